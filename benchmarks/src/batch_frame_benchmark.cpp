@@ -0,0 +1,113 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Logger.h"
+#include "TCPNetworkUtility.h"
+
+// Sends many 40-byte messages over loopback TCP through two Connections and measures
+// delivery rate and write operations per message, with and without batch frames. Each
+// write is one async_write, which for these sizes is one send syscall. The shared
+// scenarios queue one SharedBuffer over and over, as a broadcast does, and the receiver
+// reads views, so neither side copies the payloads into or out of the batch.
+struct Result {
+    double messages_per_second;
+    double writes_per_message;
+    std::uint64_t batches;
+};
+
+Result run(asio::io_context& io_context, const NetworkMessages::BatchOptions& options, bool shared, std::size_t count) {
+    asio::ip::tcp::acceptor acceptor(io_context, asio::ip::tcp::endpoint(asio::ip::make_address("127.0.0.1"), 0));
+    auto server = TCPNetworkUtility::createConnection(io_context, "server");
+    auto client = TCPNetworkUtility::createConnection(io_context, "client");
+
+    std::promise<void> connected;
+    client->socket().async_connect(acceptor.local_endpoint(), [&connected](std::error_code) { connected.set_value(); });
+    acceptor.accept(server->socket());
+    connected.get_future().wait();
+    client->socket().set_option(asio::ip::tcp::no_delay(true));
+
+    server->setBatching(options);
+    client->setBatching(options);
+
+    std::atomic<std::size_t> received{0};
+    std::promise<void> done;
+    server->readViews([&](FastVector::ByteSpan) {
+        if (received.fetch_add(1) + 1 == count) {
+            done.set_value();
+        }
+    });
+    client->read([](const FastVector::ByteVector&) {});
+    while (options.enabled && !client->peerAcceptsBatches()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    FastVector::SharedBuffer broadcast = FastVector::SharedBuffer::copyOf(FastVector::ByteVector(std::size_t{40}, 0x2A));
+    for (std::size_t i = 0; i < count; ++i) {
+        if (shared) {
+            client->write(broadcast);
+        } else {
+            FastVector::ByteVector message(std::size_t{40}, static_cast<std::uint8_t>(i));
+            client->write(std::move(message));
+        }
+    }
+    done.get_future().wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto stats = client->writeStats();
+    client->close();
+    server->close();
+    return {static_cast<double>(count) / seconds,
+            static_cast<double>(stats.writes) / static_cast<double>(stats.messages),
+            stats.batches};
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+    AsyncLogger::getInstance().setLogLevel(AsyncLogger::LogLevel::ERROR_LOG);
+
+    asio::io_context io_context;
+    auto work = asio::make_work_guard(io_context);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 2; ++i) {
+        threads.emplace_back([&io_context]() { io_context.run(); });
+    }
+
+    struct Scenario {
+        const char* name;
+        NetworkMessages::BatchOptions options;
+        bool shared;
+    };
+    const Scenario scenarios[] = {
+            {"unbatched", {false, 16 * 1024, std::chrono::microseconds(200)}, false},
+            {"batch, flush per burst", {true, 16 * 1024, std::chrono::microseconds(0)}, false},
+            {"batch, 200 us / 16 KiB", {true, 16 * 1024, std::chrono::microseconds(200)}, false},
+            {"batch, 200 us / 4 KiB", {true, 4 * 1024, std::chrono::microseconds(200)}, false},
+            {"shared, unbatched", {false, 16 * 1024, std::chrono::microseconds(200)}, true},
+            {"shared, 200 us / 16 KiB", {true, 16 * 1024, std::chrono::microseconds(200)}, true},
+    };
+
+    std::cout << count << " messages of 40 bytes over loopback\n\n";
+    std::cout << std::left << std::setw(26) << "mode" << std::setw(16) << "msgs/s" << std::setw(16) << "writes/msg"
+              << std::setw(12) << "batches" << "\n";
+    for (const auto& scenario : scenarios) {
+        Result result = run(io_context, scenario.options, scenario.shared, count);
+        std::cout << std::left << std::setw(26) << scenario.name
+                  << std::setw(16) << std::fixed << std::setprecision(0) << result.messages_per_second
+                  << std::setw(16) << std::setprecision(4) << result.writes_per_message
+                  << std::setw(12) << result.batches << "\n";
+    }
+
+    work.reset();
+    io_context.stop();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return 0;
+}
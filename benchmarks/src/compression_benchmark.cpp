@@ -0,0 +1,143 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "FrameCompression.h"
+
+// Compresses sample payloads the way a Connection does and reports the bytes saved and
+// the CPU time spent on each side. Each file is sent once as a single frame and once as
+// one frame per line; the per-line run is repeated with a fresh compressor per frame to
+// show how much of the gain comes from the history kept across frames.
+// Usage: compression_benchmark [file...]; without arguments it reads the message
+// definitions and the sample chat log checked into the repository.
+struct Result {
+    std::size_t input_bytes = 0;
+    std::size_t output_bytes = 0;
+    double compress_ms = 0;
+    double decompress_ms = 0;
+    bool ok = true;
+};
+
+Result run(const std::vector<std::string>& frames, bool shared_history, int repeat) {
+    Result result;
+    for (const auto& frame : frames) {
+        result.input_bytes += frame.size();
+    }
+
+    std::vector<FastVector::HeapByteVector> compressed(frames.size());
+    std::vector<bool> sent_compressed(frames.size());
+    double best_compress = 0;
+    double best_decompress = 0;
+    for (int run = 0; run < repeat; ++run) {
+        NetworkMessages::FrameCompressor compressor;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < frames.size(); ++i) {
+            FastVector::ByteSpan payload(reinterpret_cast<const std::uint8_t*>(frames[i].data()), frames[i].size());
+            if (shared_history) {
+                sent_compressed[i] = compressor.compress(payload, compressed[i]);
+            } else {
+                NetworkMessages::FrameCompressor fresh;
+                sent_compressed[i] = fresh.compress(payload, compressed[i]);
+            }
+        }
+        double compress_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        NetworkMessages::FrameDecompressor decompressor;
+        FastVector::ByteVector restored;
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < frames.size(); ++i) {
+            if (!sent_compressed[i]) {
+                continue;
+            }
+            if (shared_history) {
+                decompressor.decompress(compressed[i], restored);
+            } else {
+                NetworkMessages::FrameDecompressor fresh;
+                fresh.decompress(compressed[i], restored);
+            }
+            result.ok &= restored.size() == frames[i].size() &&
+                         std::equal(restored.begin(), restored.end(), frames[i].begin(),
+                                    [](std::uint8_t a, char b) { return a == static_cast<std::uint8_t>(b); });
+        }
+        double decompress_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        best_compress = run == 0 ? compress_ms : std::min(best_compress, compress_ms);
+        best_decompress = run == 0 ? decompress_ms : std::min(best_decompress, decompress_ms);
+    }
+
+    // Frames that would not shrink go out plain
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        result.output_bytes += sent_compressed[i] ? compressed[i].size() : frames[i].size();
+    }
+    result.compress_ms = best_compress;
+    result.decompress_ms = best_decompress;
+    return result;
+}
+
+void print(const std::string& name, const Result& result) {
+    double megabytes = static_cast<double>(result.input_bytes) / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(30) << name
+              << std::right << std::setw(10) << result.input_bytes
+              << std::setw(10) << result.output_bytes
+              << std::setw(8) << std::setprecision(1)
+              << 100.0 * (1.0 - static_cast<double>(result.output_bytes) / static_cast<double>(result.input_bytes)) << "%"
+              << std::setw(12) << std::setprecision(0) << megabytes / (result.compress_ms / 1000.0)
+              << std::setw(12) << megabytes / (result.decompress_ms / 1000.0) << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        files.emplace_back(argv[i]);
+    }
+    if (files.empty()) {
+        files = {SERVERKIT_SOURCE_DIR "/chat_messages.json", SERVERKIT_SOURCE_DIR "/benchmarks/data/chat_log.jsonl"};
+    }
+
+    std::cout << std::left << std::setw(30) << "input" << std::right << std::setw(10) << "bytes"
+              << std::setw(10) << "wire" << std::setw(9) << "saved"
+              << std::setw(12) << "comp MB/s" << std::setw(12) << "dec MB/s" << "\n";
+    std::cout << std::fixed;
+
+    bool ok = true;
+    for (const auto& file : files) {
+        std::ifstream in(file, std::ios::binary);
+        if (!in) {
+            std::cout << "Cannot open " << file << "\n";
+            return 1;
+        }
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        std::vector<std::string> lines;
+        std::size_t begin = 0;
+        while (begin < contents.size()) {
+            std::size_t end = contents.find('\n', begin);
+            end = end == std::string::npos ? contents.size() : end + 1;
+            lines.push_back(contents.substr(begin, end - begin));
+            begin = end;
+        }
+
+        // Enough repetitions that even the small files run for a measurable time
+        int repeat = static_cast<int>(std::clamp<std::size_t>(64 * 1024 * 1024 / (contents.size() + 1), 5, 20000));
+        Result whole = run({contents}, true, repeat);
+        Result per_line = run(lines, true, std::max(5, repeat / 10));
+        Result per_line_fresh = run(lines, false, std::max(5, repeat / 10));
+        ok &= whole.ok && per_line.ok && per_line_fresh.ok;
+
+        std::string name = file.substr(file.find_last_of("/\\") + 1);
+        print(name + " (one frame)", whole);
+        print(name + " (" + std::to_string(lines.size()) + " frames)", per_line);
+        print(name + " (no history)", per_line_fresh);
+    }
+
+    if (!ok) {
+        std::cout << "Round trip mismatch\n";
+        return 1;
+    }
+    return 0;
+}
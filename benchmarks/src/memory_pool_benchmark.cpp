@@ -0,0 +1,183 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <string>
+
+#include "MemoryPool.h"
+
+// The single-mutex chunk pool ByteVector used before the slab allocator, kept as a
+// baseline. It hands out one CHUNK_SIZE chunk regardless of the request, so every
+// backend only touches the first byte of a block to keep the comparison fair.
+class LegacyChunkPool {
+public:
+    static constexpr std::size_t CHUNK_SIZE = 32768;
+
+    LegacyChunkPool() {
+        allocate_more_chunks(16);
+    }
+
+    ~LegacyChunkPool() {
+        for (void* chunk : free_chunks_) {
+            ::operator delete(chunk);
+        }
+        for (void* chunk : used_chunks_) {
+            ::operator delete(chunk);
+        }
+    }
+
+    void* allocate(std::size_t n) {
+        std::lock_guard<std::mutex> lock(chunk_mutex);
+        std::size_t chunk_count = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        if (free_chunks_.size() < chunk_count) {
+            allocate_more_chunks(chunk_count - free_chunks_.size());
+        }
+        void* result = free_chunks_.back();
+        free_chunks_.pop_back();
+        for (std::size_t i = 1; i < chunk_count; ++i) {
+            used_chunks_.push_back(free_chunks_.back());
+            free_chunks_.pop_back();
+        }
+        return result;
+    }
+
+    void deallocate(void* p, std::size_t n) {
+        if (p == nullptr) return;
+        std::lock_guard<std::mutex> lock(chunk_mutex);
+        std::size_t chunk_count = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        free_chunks_.push_back(p);
+        for (std::size_t i = 1; i < chunk_count; ++i) {
+            if (!used_chunks_.empty()) {
+                free_chunks_.push_back(used_chunks_.back());
+                used_chunks_.pop_back();
+            }
+        }
+    }
+
+private:
+    void allocate_more_chunks(std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            free_chunks_.push_back(::operator new(CHUNK_SIZE));
+        }
+    }
+
+    std::mutex chunk_mutex;
+    std::vector<void*> free_chunks_;
+    std::vector<void*> used_chunks_;
+};
+
+struct Slot {
+    void* data = nullptr;
+    std::size_t size = 0;
+    std::vector<std::uint8_t> vector;
+};
+
+struct LegacyBackend {
+    LegacyChunkPool& pool;
+    void allocate(Slot& slot, std::size_t n) {
+        slot.data = pool.allocate(n);
+        slot.size = n;
+        static_cast<std::uint8_t*>(slot.data)[0] = 1;
+    }
+    void release(Slot& slot) {
+        pool.deallocate(slot.data, slot.size);
+        slot.data = nullptr;
+    }
+};
+
+struct SlabBackend {
+    void allocate(Slot& slot, std::size_t n) {
+        auto block = FastVector::MemoryPool::getInstance().allocate(n);
+        slot.data = block.data;
+        slot.size = block.size;
+        static_cast<std::uint8_t*>(slot.data)[0] = 1;
+    }
+    void release(Slot& slot) {
+        FastVector::MemoryPool::getInstance().deallocate(slot.data, slot.size);
+        slot.data = nullptr;
+    }
+};
+
+struct VectorBackend {
+    void allocate(Slot& slot, std::size_t n) {
+        std::vector<std::uint8_t> vector;
+        vector.reserve(n);
+        vector.data()[0] = 1;
+        slot.vector = std::move(vector);
+        slot.data = slot.vector.data();
+    }
+    void release(Slot& slot) {
+        std::vector<std::uint8_t>().swap(slot.vector);
+        slot.data = nullptr;
+    }
+};
+
+// Each thread keeps a window of live blocks and replaces one per iteration, so the
+// allocator sees a steady mix of allocations and frees across all size classes.
+template<typename Backend>
+double run_workload(Backend backend, int thread_count, int iterations_per_thread) {
+    constexpr std::size_t window = 64;
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([backend, t, iterations_per_thread]() mutable {
+            std::mt19937 gen(1234 + t);
+            std::uniform_int_distribution<std::size_t> size_dis(4097, 256 * 1024);
+            std::vector<Slot> slots(window);
+            for (int i = 0; i < iterations_per_thread; ++i) {
+                Slot& slot = slots[i % window];
+                if (slot.data != nullptr) {
+                    backend.release(slot);
+                }
+                backend.allocate(slot, size_dis(gen));
+            }
+            for (Slot& slot : slots) {
+                if (slot.data != nullptr) {
+                    backend.release(slot);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double total_ops = static_cast<double>(thread_count) * iterations_per_thread;
+    return std::chrono::duration<double, std::nano>(end - start).count() / total_ops;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::stoi(argv[1]) : 200000;
+    const int thread_counts[] = {1, 2, 4, 8, 16};
+
+    LegacyChunkPool legacy_pool;
+
+    std::cout << "Allocate/free cycles, sizes 4 KiB..256 KiB, " << iterations << " iterations per thread\n\n";
+    std::cout << std::left << std::setw(10) << "threads"
+              << std::setw(22) << "legacy chunk pool"
+              << std::setw(22) << "slab pool"
+              << std::setw(22) << "std::vector<uint8_t>" << "\n";
+
+    for (int threads : thread_counts) {
+        // Warm-up so every backend starts with its free lists populated
+        run_workload(LegacyBackend{legacy_pool}, threads, iterations / 10);
+        run_workload(SlabBackend{}, threads, iterations / 10);
+
+        double legacy = run_workload(LegacyBackend{legacy_pool}, threads, iterations);
+        double slab = run_workload(SlabBackend{}, threads, iterations);
+        double vector = run_workload(VectorBackend{}, threads, iterations);
+
+        std::cout << std::left << std::setw(10) << threads
+                  << std::setw(22) << (std::to_string(static_cast<int>(legacy)) + " ns/op")
+                  << std::setw(22) << (std::to_string(static_cast<int>(slab)) + " ns/op")
+                  << std::setw(22) << (std::to_string(static_cast<int>(vector)) + " ns/op") << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "BinaryData.h"
+#include "MessageSchema.h"
+
+// A fixed-layout telemetry record: 40 bytes, no padding
+struct Telemetry {
+    std::uint64_t timestamp;
+    std::uint32_t entity_id;
+    float x, y, z;
+    float vx, vy, vz;
+    std::uint16_t flags;
+    std::uint16_t sequence;
+
+    SERVERKIT_PACKED_MESSAGE(Telemetry, 40, timestamp, entity_id, x, y, z, vx, vy, vz, flags, sequence)
+};
+
+using Codec = NetworkMessages::MessageCodec<Telemetry>;
+using Packed = NetworkMessages::PackedMessage<Telemetry>;
+
+// Best of several runs, so page faults on the first touch of a buffer are not counted
+template<typename Func>
+double millis(Func&& func) {
+    double best = 0;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = run == 0 ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+std::uint64_t checksum(const std::vector<Telemetry>& records) {
+    std::uint64_t sum = 0;
+    for (const auto& record : records) {
+        sum += record.timestamp + record.entity_id + record.sequence + static_cast<std::uint64_t>(record.x);
+    }
+    return sum;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    std::vector<Telemetry> records(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        float f = static_cast<float>(i);
+        records[i] = {1700000000000ULL + i, static_cast<std::uint32_t>(i % 5000), f, f * 0.5f, -f,
+                      1.0f, 2.0f, 3.0f, static_cast<std::uint16_t>(i & 0xFF), static_cast<std::uint16_t>(i)};
+    }
+    const std::uint64_t expected = checksum(records);
+
+    // Every path writes the same bytes, so each decoder reads the packed encoding
+    FastVector::ByteVector appended;
+    FastVector::ByteVector fieldwise;
+    FastVector::ByteVector packed;
+    appended.reserve(count * sizeof(Telemetry));
+    fieldwise.resize_uninitialized(count * sizeof(Telemetry));
+    packed.resize_uninitialized(count * sizeof(Telemetry));
+    std::vector<Telemetry> decoded(count);
+    bool ok = true;
+
+    double append_encode = millis([&]() {
+        appended.clear();
+        for (const auto& r : records) {
+            NetworkMessages::BinaryData::append_bytes(appended, r.timestamp);
+            NetworkMessages::BinaryData::append_bytes(appended, r.entity_id);
+            NetworkMessages::BinaryData::append_bytes(appended, r.x);
+            NetworkMessages::BinaryData::append_bytes(appended, r.y);
+            NetworkMessages::BinaryData::append_bytes(appended, r.z);
+            NetworkMessages::BinaryData::append_bytes(appended, r.vx);
+            NetworkMessages::BinaryData::append_bytes(appended, r.vy);
+            NetworkMessages::BinaryData::append_bytes(appended, r.vz);
+            NetworkMessages::BinaryData::append_bytes(appended, r.flags);
+            NetworkMessages::BinaryData::append_bytes(appended, r.sequence);
+        }
+    });
+    double fieldwise_encode = millis([&]() {
+        FastVector::ByteWriter writer(fieldwise.data(), fieldwise.size());
+        for (const auto& r : records) {
+            Codec::write_each_field(writer, r);
+        }
+    });
+    double packed_encode = millis([&]() {
+        FastVector::ByteWriter writer(packed.data(), packed.size());
+        for (const auto& r : records) {
+            Packed::write(writer, r);
+        }
+    });
+    ok &= appended.size() == packed.size() && std::equal(appended.begin(), appended.end(), packed.begin());
+    ok &= std::equal(fieldwise.begin(), fieldwise.end(), packed.begin());
+
+    double read_bytes_decode = millis([&]() {
+        std::size_t offset = 0;
+        for (auto& r : decoded) {
+            r.timestamp = NetworkMessages::BinaryData::read_bytes<std::uint64_t>(packed, offset);
+            r.entity_id = NetworkMessages::BinaryData::read_bytes<std::uint32_t>(packed, offset);
+            r.x = NetworkMessages::BinaryData::read_bytes<float>(packed, offset);
+            r.y = NetworkMessages::BinaryData::read_bytes<float>(packed, offset);
+            r.z = NetworkMessages::BinaryData::read_bytes<float>(packed, offset);
+            r.vx = NetworkMessages::BinaryData::read_bytes<float>(packed, offset);
+            r.vy = NetworkMessages::BinaryData::read_bytes<float>(packed, offset);
+            r.vz = NetworkMessages::BinaryData::read_bytes<float>(packed, offset);
+            r.flags = NetworkMessages::BinaryData::read_bytes<std::uint16_t>(packed, offset);
+            r.sequence = NetworkMessages::BinaryData::read_bytes<std::uint16_t>(packed, offset);
+        }
+    });
+    ok &= checksum(decoded) == expected;
+
+    decoded.assign(count, Telemetry{});
+    double fieldwise_decode = millis([&]() {
+        FastVector::ByteReader reader(packed);
+        for (auto& r : decoded) {
+            Codec::read_each_field(reader, r);
+        }
+    });
+    ok &= checksum(decoded) == expected;
+
+    decoded.assign(count, Telemetry{});
+    double packed_decode = millis([&]() {
+        FastVector::ByteReader reader(packed);
+        for (auto& r : decoded) {
+            Packed::read(reader, r);
+        }
+    });
+    ok &= checksum(decoded) == expected;
+
+    // The same messages through a 4 KiB buffer that stays in L1, as when each message is
+    // framed on its own; this isolates the per-message encoding cost from memory bandwidth
+    const std::size_t batch = 4096 / sizeof(Telemetry);
+    FastVector::ByteVector hot;
+    hot.resize_uninitialized(batch * sizeof(Telemetry));
+    auto hot_encode = [&](auto write) {
+        return millis([&]() {
+            for (std::size_t i = 0; i < count; i += batch) {
+                FastVector::ByteWriter writer(hot.data(), hot.size());
+                for (std::size_t k = i; k < std::min(count, i + batch); ++k) {
+                    write(writer, records[k]);
+                }
+            }
+        });
+    };
+    auto hot_decode = [&](auto read) {
+        return millis([&]() {
+            for (std::size_t i = 0; i < count; i += batch) {
+                FastVector::ByteReader reader(hot);
+                for (std::size_t k = 0; k < batch; ++k) {
+                    read(reader, decoded[k]);
+                }
+            }
+        });
+    };
+    double hot_fieldwise_encode = hot_encode([](FastVector::ByteWriter& w, const Telemetry& r) { Codec::write_each_field(w, r); });
+    double hot_packed_encode = hot_encode([](FastVector::ByteWriter& w, const Telemetry& r) { Packed::write(w, r); });
+    double hot_fieldwise_decode = hot_decode([](FastVector::ByteReader& r, Telemetry& t) { Codec::read_each_field(r, t); });
+    double hot_packed_decode = hot_decode([](FastVector::ByteReader& r, Telemetry& t) { Packed::read(r, t); });
+
+    if (!ok) {
+        std::cout << "Encodings or round trips do not match\n";
+        return 1;
+    }
+
+    std::cout << count << " Telemetry messages (" << sizeof(Telemetry) << " bytes each), time in ms\n\n";
+    std::cout << std::left << std::setw(26) << "path" << std::setw(12) << "encode" << std::setw(12) << "decode" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::left << std::setw(26) << "append_bytes/read_bytes" << std::setw(12) << append_encode << std::setw(12) << read_bytes_decode << "\n";
+    std::cout << std::left << std::setw(26) << "MessageCodec field-wise" << std::setw(12) << fieldwise_encode << std::setw(12) << fieldwise_decode << "\n";
+    std::cout << std::left << std::setw(26) << "PackedMessage" << std::setw(12) << packed_encode << std::setw(12) << packed_decode << "\n";
+    std::cout << "\nThrough a cache-resident buffer:\n";
+    std::cout << std::left << std::setw(26) << "MessageCodec field-wise" << std::setw(12) << hot_fieldwise_encode << std::setw(12) << hot_fieldwise_decode << "\n";
+    std::cout << std::left << std::setw(26) << "PackedMessage" << std::setw(12) << hot_packed_encode << std::setw(12) << hot_packed_decode << "\n";
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <string>
+
+#include "ByteVector.h"
+
+// Every thread runs tight allocate/free cycles on a handful of size classes, which is
+// the pattern the AsioThreadPool workers produce when reading and writing frames. With
+// the per-thread magazines the pool should scale with the thread count instead of
+// serializing on a shared mutex.
+template<typename Cycle>
+double run_contention(int thread_count, int cycles_per_thread, Cycle cycle) {
+    std::atomic<bool> go{false};
+    std::atomic<int> ready{0};
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (int i = 0; i < cycles_per_thread; ++i) {
+                cycle(t, i);
+            }
+        });
+    }
+
+    while (ready.load() < thread_count) {
+        std::this_thread::yield();
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(thread_count) * cycles_per_thread / seconds / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    int cycles = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    const int thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+    const std::size_t sizes[] = {4096 + 1, 8192, 16384, 65536};
+
+    std::cout << "Allocate/free cycles per thread: " << cycles << "\n";
+    std::cout << "Throughput in million cycles per second (all threads)\n\n";
+    std::cout << std::left << std::setw(10) << "threads"
+              << std::setw(16) << "MemoryPool"
+              << std::setw(16) << "ByteVector"
+              << std::setw(22) << "std::vector<uint8_t>" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (int threads : thread_counts) {
+        double pool = run_contention(threads, cycles, [&](int t, int i) {
+            auto& memory_pool = FastVector::MemoryPool::getInstance();
+            auto block = memory_pool.allocate(sizes[(t + i) & 3]);
+            static_cast<volatile std::uint8_t*>(block.data)[0] = 1;
+            memory_pool.deallocate(block.data, block.size);
+        });
+
+        double byte_vector = run_contention(threads, cycles, [&](int t, int i) {
+            FastVector::ByteVector buffer;
+            buffer.reserve(sizes[(t + i) & 3]);
+            static_cast<volatile std::uint8_t*>(buffer.data())[0] = 1;
+        });
+
+        double vector = run_contention(threads, cycles, [&](int t, int i) {
+            std::vector<std::uint8_t> buffer;
+            buffer.reserve(sizes[(t + i) & 3]);
+            static_cast<volatile std::uint8_t*>(buffer.data())[0] = 1;
+        });
+
+        std::cout << std::left << std::setw(10) << threads
+                  << std::setw(16) << pool
+                  << std::setw(16) << byte_vector
+                  << std::setw(22) << vector << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <string>
+
+#include "ByteVector.h"
+
+// Models the receive path of Connection::do_read_body: a frame buffer is sized for the
+// payload and then overwritten in full by the socket. The socket is stood in for by a
+// memcpy from a pre-filled source, which is what the kernel does on recv(). Sizing the
+// buffer with ByteVector(count) zero-fills it first, so every payload byte is written
+// twice; resize_uninitialized() and append_uninitialized()/commit() write it once.
+template<typename Receive>
+double run_frames(std::size_t frame_size, int frames, const std::vector<std::uint8_t>& source, Receive receive) {
+    std::uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) {
+        checksum += receive(frame_size, source);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // Keep the work observable so the copies are not optimized away
+    if (checksum == 42) {
+        std::cout << "";
+    }
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(frame_size) * frames / seconds / (1024.0 * 1024.0 * 1024.0);
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t total_bytes = (argc > 1 ? std::stoul(argv[1]) : 4096) * 1024 * 1024;  // MiB per run
+    const std::size_t frame_sizes[] = {64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024};
+
+    std::vector<std::uint8_t> source(frame_sizes[4]);
+    for (std::size_t i = 0; i < source.size(); ++i) {
+        source[i] = static_cast<std::uint8_t>(i * 31);
+    }
+
+    std::cout << "Receive path, " << total_bytes / (1024 * 1024) << " MiB per run\n";
+    std::cout << "Throughput in GiB/s of payload received\n\n";
+    std::cout << std::left << std::setw(12) << "frame"
+              << std::setw(22) << "ByteVector(count)"
+              << std::setw(24) << "resize_uninitialized"
+              << std::setw(24) << "append_uninitialized" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (std::size_t frame_size : frame_sizes) {
+        int frames = static_cast<int>(std::max<std::size_t>(total_bytes / frame_size, 1));
+
+        auto zero_filled = [](std::size_t n, const std::vector<std::uint8_t>& src) -> std::uint64_t {
+            FastVector::ByteVector buffer(n);
+            std::memcpy(buffer.data(), src.data(), n);
+            return buffer[n - 1];
+        };
+        auto uninitialized = [](std::size_t n, const std::vector<std::uint8_t>& src) -> std::uint64_t {
+            FastVector::ByteVector buffer;
+            buffer.resize_uninitialized(n);
+            std::memcpy(buffer.data(), src.data(), n);
+            return buffer[n - 1];
+        };
+        auto appended = [](std::size_t n, const std::vector<std::uint8_t>& src) -> std::uint64_t {
+            FastVector::ByteVector buffer;
+            auto window = buffer.append_uninitialized(n);
+            std::memcpy(window.data(), src.data(), n);
+            buffer.commit(n);
+            return buffer[n - 1];
+        };
+
+        // Warm-up so the pool has blocks of this class cached
+        run_frames(frame_size, frames / 10 + 1, source, uninitialized);
+
+        double zeroed = run_frames(frame_size, frames, source, zero_filled);
+        double resized = run_frames(frame_size, frames, source, uninitialized);
+        double committed = run_frames(frame_size, frames, source, appended);
+
+        std::cout << std::left << std::setw(12) << (std::to_string(frame_size / 1024) + " KiB")
+                  << std::setw(22) << zeroed
+                  << std::setw(24) << resized
+                  << std::setw(24) << committed << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,450 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "BinaryData.h"
+#include "ByteVector.h"
+#include "DynamicPayload.h"
+#include "HeapAllocationCounter.h"
+#include "HTTPMessage.h"
+#include "ChatMessage.h"
+#include "chat_messages.h"  // Generated from chat_messages.json
+#include "JsonMessage.h"
+#include "MessageHandler.h"
+#include "MessagePool.h"
+
+// Serialization micro-benchmarks with a small in-tree harness. Each benchmark runs its
+// operation in batches long enough that reading the clock is negligible, after a warmup,
+// and reports the median and 99th percentile of the per-batch ns/op, the bytes each
+// operation encodes or parses, and heap allocations per operation.
+//
+// Usage: serverkit_bench [--filter text] [--samples n] [--warmup-ms n]
+//                        [--definitions chat_messages.json] [--json results.json]
+// The definitions default to the repository's chat_messages.json. The JSON file holds
+// one record per benchmark, in a fixed order, so results from two commits can be
+// compared with any diff tool.
+
+// Keeps the compiler from discarding a result that is otherwise unused
+template<typename T>
+inline void keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct Result {
+    std::string name;
+    double median_ns = 0;
+    double p99_ns = 0;
+    double bytes_per_op = 0;
+    double allocations_per_op = 0;
+    std::size_t operations = 0;
+};
+
+class Bench {
+public:
+    std::string filter;
+    std::size_t samples = 101;
+    std::chrono::milliseconds warmup{50};
+    std::vector<Result> results;
+
+    // op runs one operation; bytes is what one operation encodes or parses, 0 if n/a
+    void run(const std::string& name, std::size_t bytes, const std::function<void()>& op) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            return;
+        }
+
+        // Batch size: enough operations for about 100 us, so each sample is far above the
+        // resolution and cost of steady_clock
+        std::size_t batch = 1;
+        while (true) {
+            double elapsed = time_batch(op, batch);
+            if (elapsed >= 100e3 || batch >= (std::size_t{1} << 24)) {
+                break;
+            }
+            batch *= elapsed < 10e3 ? 10 : 2;
+        }
+
+        auto warmup_end = std::chrono::steady_clock::now() + warmup;
+        while (std::chrono::steady_clock::now() < warmup_end) {
+            time_batch(op, batch);
+        }
+
+        std::vector<double> per_op(samples);
+        std::size_t allocations_before = g_heap_allocations.load(std::memory_order_relaxed);
+        for (auto& sample : per_op) {
+            sample = time_batch(op, batch) / static_cast<double>(batch);
+        }
+        std::size_t allocations = g_heap_allocations.load(std::memory_order_relaxed) - allocations_before;
+        std::sort(per_op.begin(), per_op.end());
+
+        Result result;
+        result.name = name;
+        result.median_ns = per_op[per_op.size() / 2];
+        result.p99_ns = per_op[std::min(per_op.size() - 1, (per_op.size() * 99 + 99) / 100 - 1)];
+        result.bytes_per_op = static_cast<double>(bytes);
+        result.operations = samples * batch;
+        result.allocations_per_op = static_cast<double>(allocations) / static_cast<double>(result.operations);
+        print(result);
+        results.push_back(std::move(result));
+    }
+
+    static void printHeader() {
+        std::cout << std::left << std::setw(40) << "benchmark" << std::right << std::setw(12) << "median ns"
+                  << std::setw(12) << "p99 ns" << std::setw(10) << "bytes" << std::setw(10) << "allocs" << "\n";
+    }
+
+    void writeJson(const std::string& path) const {
+        nlohmann::json records = nlohmann::json::array();
+        for (const auto& result : results) {
+            records.push_back({{"name", result.name},
+                               {"median_ns", result.median_ns},
+                               {"p99_ns", result.p99_ns},
+                               {"bytes_per_op", result.bytes_per_op},
+                               {"allocations_per_op", result.allocations_per_op},
+                               {"operations", result.operations}});
+        }
+        nlohmann::json document = {{"samples", samples}, {"benchmarks", records}};
+        std::ofstream out(path);
+        out << document.dump(2) << "\n";
+    }
+
+private:
+    static double time_batch(const std::function<void()>& op, std::size_t batch) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < batch; ++i) {
+            op();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static void print(const Result& result) {
+        std::cout << std::left << std::setw(40) << result.name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << result.median_ns << std::setw(12) << result.p99_ns
+                  << std::setprecision(0) << std::setw(10) << result.bytes_per_op
+                  << std::setprecision(2) << std::setw(10) << result.allocations_per_op << "\n";
+    }
+};
+
+void byte_vector_benchmarks(Bench& bench) {
+    const std::vector<std::uint8_t> source(16 * 1024, 0x5A);
+
+    FastVector::ByteVector reused;
+    bench.run("ByteVector/append_64B_reused", 64, [&]() {
+        reused.clear();
+        reused.insert(reused.end(), source.begin(), source.begin() + 64);
+        keep(reused.data());
+    });
+    bench.run("ByteVector/construct_1KiB_inline", 1024, [&]() {
+        FastVector::ByteVector vector(source.begin(), source.begin() + 1024);
+        keep(vector.data());
+    });
+    bench.run("ByteVector/construct_16KiB_pooled", source.size(), [&]() {
+        FastVector::ByteVector vector(source.begin(), source.end());
+        keep(vector.data());
+    });
+    FastVector::ByteVector original(source.begin(), source.begin() + 256);
+    bench.run("ByteVector/copy_256B", 256, [&]() {
+        FastVector::ByteVector copy(original);
+        keep(copy.data());
+    });
+}
+
+void binary_data_benchmarks(Bench& bench) {
+    using NetworkMessages::BinaryData;
+
+    FastVector::ByteVector scalars;
+    bench.run("BinaryData/append_bytes_16_uint32", 16 * sizeof(std::uint32_t), [&]() {
+        scalars.clear();
+        for (std::uint32_t i = 0; i < 16; ++i) {
+            BinaryData::append_bytes(scalars, i);
+        }
+        keep(scalars.data());
+    });
+    FastVector::ByteVector written(16 * sizeof(std::uint32_t));
+    bench.run("BinaryData/write_bytes_16_uint32", written.size(), [&]() {
+        FastVector::ByteWriter writer(written.data(), written.size());
+        for (std::uint32_t i = 0; i < 16; ++i) {
+            BinaryData::write_bytes(writer, i);
+        }
+        keep(written.data());
+    });
+    bench.run("BinaryData/read_bytes_16_uint32", scalars.size(), [&]() {
+        std::size_t offset = 0;
+        std::uint32_t sum = 0;
+        for (int i = 0; i < 16; ++i) {
+            sum += BinaryData::read_bytes<std::uint32_t>(scalars, offset);
+        }
+        keep(sum);
+    });
+
+    const std::string text(48, 'x');
+    FastVector::ByteVector string_bytes;
+    bench.run("BinaryData/append_bytes_string_48", BinaryData::byte_size(text), [&]() {
+        string_bytes.clear();
+        BinaryData::append_bytes(string_bytes, text);
+        keep(string_bytes.data());
+    });
+    bench.run("BinaryData/read_bytes_string_48", string_bytes.size(), [&]() {
+        std::size_t offset = 0;
+        std::string value = BinaryData::read_bytes<std::string>(string_bytes, offset);
+        keep(value.data());
+    });
+}
+
+void chat_message_benchmarks(Bench& bench) {
+    using NetworkMessages::ChatMessage;
+
+    NetworkMessages::BinaryMessage<ChatMessage> message(ChatMessage{"user_0042", std::string(50, 'm')});
+    FastVector::ByteVector serialized = message.serialize();
+    bench.run("BinaryMessage<ChatMessage>/serialize", serialized.size(), [&]() {
+        FastVector::ByteVector bytes = message.serialize();
+        keep(bytes.data());
+    });
+    bench.run("BinaryMessage<ChatMessage>/serializeFrame", serialized.size() + sizeof(std::uint32_t), [&]() {
+        FastVector::ByteVector frame = message.serializeFrame();
+        keep(frame.data());
+    });
+    NetworkMessages::BinaryMessage<ChatMessage> decoded(ChatMessage{});
+    bench.run("BinaryMessage<ChatMessage>/deserialize", serialized.size(), [&]() {
+        std::size_t offset = 0;
+        decoded.deserialize(serialized, offset);
+        keep(decoded.getPayload().message.data());
+    });
+    bench.run("ChatMessage::View/deserialize", serialized.size(), [&]() {
+        FastVector::ByteReader reader(serialized, sizeof(short));
+        ChatMessage::View view;
+        NetworkMessages::MessageCodec<ChatMessage::View>::read(reader, view);
+        keep(view.message.data());
+    });
+
+    // A message per send, fresh from the heap or recycled from the thread's pool
+    const std::string username = "user_0042";
+    const std::string text(50, 'm');
+    bench.run("BinaryMessage<ChatMessage>/new_serialize", serialized.size(), [&]() {
+        auto fresh = std::make_unique<NetworkMessages::BinaryMessage<ChatMessage>>(ChatMessage{});
+        fresh->getPayload().username = username;
+        fresh->getPayload().message = text;
+        FastVector::ByteVector bytes = fresh->serialize();
+        keep(bytes.data());
+    });
+    bench.run("MessagePool<ChatMessage>/acquire_serialize", serialized.size(), [&]() {
+        auto pooled = NetworkMessages::acquireMessage<ChatMessage>();
+        pooled->getPayload().username = username;
+        pooled->getPayload().message = text;
+        FastVector::ByteVector bytes = pooled->serialize();
+        keep(bytes.data());
+    });
+}
+
+void dynamic_payload_benchmarks(Bench& bench, const std::string& definitions) {
+    try {
+        JSONPayload::MessageFactory::loadDefinitions(definitions);
+    } catch (const std::exception& e) {
+        std::cout << "Skipping DynamicPayload: cannot load " << definitions << " (" << e.what() << ")\n";
+        return;
+    }
+
+    const std::string username = "user_0042";
+    const std::string text(50, 'm');
+    FastVector::ByteVector serialized = JSONPayload::createMessage("ChatMessage", text, username)->serialize();
+    bench.run("DynamicPayload/create_and_serialize", serialized.size(), [&]() {
+        auto message = JSONPayload::createMessage("ChatMessage", text, username);
+        FastVector::ByteVector bytes = message->serialize();
+        keep(bytes.data());
+    });
+    auto usernameField = JSONPayload::MessageFactory::field("ChatMessage", "username");
+    auto messageField = JSONPayload::MessageFactory::field("ChatMessage", "message");
+    bench.run("DynamicPayload/acquire_and_serialize", serialized.size(), [&]() {
+        auto pooled = JSONPayload::MessageFactory::acquireMessage(0);
+        pooled->getPayload().set(usernameField, username);
+        pooled->getPayload().set(messageField, text);
+        FastVector::ByteVector bytes = pooled->serialize();
+        keep(bytes.data());
+    });
+    auto message = JSONPayload::createMessage("ChatMessage", text, username);
+    bench.run("DynamicPayload/serialize", serialized.size(), [&]() {
+        FastVector::ByteVector bytes = message->serialize();
+        keep(bytes.data());
+    });
+    auto decoded = JSONPayload::MessageFactory::createMessage("ChatMessage");
+    bench.run("DynamicPayload/deserialize", serialized.size(), [&]() {
+        std::size_t offset = 0;
+        decoded->deserialize(serialized, offset);
+        keep(decoded->getPayload().get<std::string>(1).data());
+    });
+    // The receive path: look up the definition by wire type, then decode in place
+    FastVector::ByteSpan payload(serialized.data() + sizeof(short), serialized.size() - sizeof(short));
+    JSONPayload::DynamicPayload target;
+    bench.run("DynamicPayload/decode_by_type", serialized.size(), [&]() {
+        JSONPayload::MessageFactory::decode(0, payload, target);
+        keep(target.get<std::string>(1).data());
+    });
+    MessageHandler<int> handler;
+    JSONPayload::registerPayloadHandler(handler, 0, [](const int&, const JSONPayload::DynamicPayload& received) {
+        keep(received.get<std::string>(1).data());
+    });
+    bench.run("MessageHandler/dispatch_payload", serialized.size(), [&]() {
+        handler.handleMessage(0, serialized);
+    });
+}
+
+// The structs serverkit_codegen generates from chat_messages.json, for comparison with
+// the DynamicPayload path that interprets the same definitions. generated_messages_test
+// checks that both agree on the wire.
+void generated_message_benchmarks(Bench& bench) {
+    const std::string username = "user_0042";
+    const std::string text(50, 'm');
+    ChatSchema::ChatMessage message{text, username};
+    FastVector::ByteVector serialized = NetworkMessages::serializeMessage(message);
+
+    bench.run("Generated<ChatMessage>/serialize", serialized.size(), [&]() {
+        FastVector::ByteVector bytes = NetworkMessages::serializeMessage(message);
+        keep(bytes.data());
+    });
+    ChatSchema::ChatMessage decoded;
+    bench.run("Generated<ChatMessage>/deserialize", serialized.size(), [&]() {
+        FastVector::ByteReader reader(serialized, sizeof(short));
+        NetworkMessages::MessageCodec<ChatSchema::ChatMessage>::read(reader, decoded);
+        keep(decoded.message.data());
+    });
+}
+
+void json_message_benchmarks(Bench& bench) {
+    JsonMessage message;
+    message.json_data = {{"action", "get_user"},
+                         {"id", 42},
+                         {"fields", {"name", "email", "created_at"}},
+                         {"options", {{"include_deleted", false}, {"limit", 25}}}};
+    FastVector::ByteVector serialized = message.serialize();
+    bench.run("JsonMessage/serialize", serialized.size(), [&]() {
+        FastVector::ByteVector bytes = message.serialize();
+        keep(bytes.data());
+    });
+    JsonMessage decoded;
+    bench.run("JsonMessage/deserialize", serialized.size(), [&]() {
+        std::size_t offset = 0;
+        decoded.deserialize(serialized, offset);
+        keep(decoded.json_data.size());
+    });
+}
+
+void http_benchmarks(Bench& bench) {
+    const std::string request =
+            "POST /api/v1/messages?channel=general&limit=50 HTTP/1.1\r\n"
+            "Host: chat.example.com\r\n"
+            "User-Agent: serverkit-bench/1.0\r\n"
+            "Accept: application/json\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: 52\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n";
+    const std::string body = R"({"username":"user_0042","message":"hello, everyone"})";
+    FastVector::ByteSpan header_bytes(reinterpret_cast<const std::uint8_t*>(request.data()), request.size());
+    FastVector::ByteSpan body_bytes(reinterpret_cast<const std::uint8_t*>(body.data()), body.size());
+
+    bench.run("HTTP/parse_request_header", request.size(), [&]() {
+        HTTPHeader header;
+        header.deserialize(header_bytes);
+        keep(header.getHeaders().size());
+    });
+    bench.run("HTTP/parse_request", request.size() + body.size(), [&]() {
+        HTTPHeader header;
+        header.deserialize(header_bytes);
+        HTTPBody parsed_body;
+        parsed_body.deserialize(body_bytes);
+        HTTPMessage message;
+        message.setHeader(std::move(header));
+        message.setBody(std::move(parsed_body));
+        keep(message.getBody().getContent().size());
+    });
+
+    HTTPMessage response;
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(200);
+    response.setStatusMessage("OK");
+    response.addHeader("Content-Type", "application/json");
+    response.addHeader("Content-Length", std::to_string(body.size()));
+    HTTPBody response_body;
+    response_body.setContent(body);
+    response.setBody(response_body);
+    bench.run("HTTP/serialize_response", response.serialize().size(), [&]() {
+        FastVector::BufferChain chain = response.serialize();
+        keep(chain.size());
+    });
+}
+
+const char* const USAGE =
+        "Usage: serverkit_bench [--filter text] [--samples n] [--warmup-ms n]\n"
+        "                       [--definitions chat_messages.json] [--json results.json]\n";
+
+// A whole decimal number and nothing else; nullopt for anything else
+std::optional<std::size_t> parse_count(const std::string& text) {
+    std::size_t value = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || error != std::errc() || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+int main(int argc, char* argv[]) {
+    Bench bench;
+    std::string json_path;
+    std::string definitions = SERVERKIT_SOURCE_DIR "/chat_messages.json";
+    for (int i = 1; i < argc; i += 2) {
+        std::string option = argv[i];
+        if (i + 1 == argc) {
+            std::cerr << "Missing value for " << option << "\n" << USAGE;
+            return 1;
+        }
+        std::string value = argv[i + 1];
+        if (option == "--filter") {
+            bench.filter = value;
+        } else if (option == "--samples" || option == "--warmup-ms") {
+            std::optional<std::size_t> count = parse_count(value);
+            if (!count) {
+                std::cerr << "Invalid value for " << option << ": " << value << "\n" << USAGE;
+                return 1;
+            }
+            if (option == "--samples") {
+                bench.samples = std::max<std::size_t>(1, *count);
+            } else {
+                bench.warmup = std::chrono::milliseconds(*count);
+            }
+        } else if (option == "--definitions") {
+            definitions = value;
+        } else if (option == "--json") {
+            json_path = value;
+        } else {
+            std::cerr << "Unknown option " << option << "\n" << USAGE;
+            return 1;
+        }
+    }
+
+    Bench::printHeader();
+    byte_vector_benchmarks(bench);
+    binary_data_benchmarks(bench);
+    chat_message_benchmarks(bench);
+    dynamic_payload_benchmarks(bench, definitions);
+    generated_message_benchmarks(bench);
+    json_message_benchmarks(bench);
+    http_benchmarks(bench);
+
+    if (!json_path.empty()) {
+        bench.writeJson(json_path);
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "BinaryData.h"
+#include "Utf8.h"
+
+// The char32_t transcoder BinaryData used before strings were passed through, kept as a
+// baseline. It widens each char on its own, so it re-encodes every byte >= 0x80 and
+// truncates code points on the way back; it only round-trips ASCII.
+namespace Legacy
+{
+    void append_string(FastVector::ByteVector& out, const std::string& str) {
+        FastVector::ShortByteVector bytes;
+        bytes.reserve(str.size() * 4);
+        for (char32_t c : str) {
+            if (c <= 0x7F) {
+                bytes.push_back(static_cast<std::uint8_t>(c));
+            } else if (c <= 0x7FF) {
+                bytes.push_back(static_cast<std::uint8_t>(0xC0 | (c >> 6)));
+                bytes.push_back(static_cast<std::uint8_t>(0x80 | (c & 0x3F)));
+            } else if (c <= 0xFFFF) {
+                bytes.push_back(static_cast<std::uint8_t>(0xE0 | (c >> 12)));
+                bytes.push_back(static_cast<std::uint8_t>(0x80 | ((c >> 6) & 0x3F)));
+                bytes.push_back(static_cast<std::uint8_t>(0x80 | (c & 0x3F)));
+            } else {
+                bytes.push_back(static_cast<std::uint8_t>(0xF0 | (c >> 18)));
+                bytes.push_back(static_cast<std::uint8_t>(0x80 | ((c >> 12) & 0x3F)));
+                bytes.push_back(static_cast<std::uint8_t>(0x80 | ((c >> 6) & 0x3F)));
+                bytes.push_back(static_cast<std::uint8_t>(0x80 | (c & 0x3F)));
+            }
+        }
+        NetworkMessages::BinaryData::append_bytes(out, static_cast<std::uint32_t>(bytes.size()));
+        out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+
+    std::string read_string(const FastVector::ByteVector& data, std::size_t& offset) {
+        auto length = NetworkMessages::BinaryData::read_bytes<std::uint32_t>(data, offset);
+        std::string result;
+        result.reserve(length);
+        const std::uint8_t* cur = data.data() + offset;
+        const std::uint8_t* end = cur + length;
+        while (cur < end) {
+            if ((*cur & 0x80) == 0) {
+                result.push_back(static_cast<char>(*cur++));
+            } else if ((*cur & 0xE0) == 0xC0) {
+                result.push_back(static_cast<char>(((cur[0] & 0x1F) << 6) | (cur[1] & 0x3F)));
+                cur += 2;
+            } else if ((*cur & 0xF0) == 0xE0) {
+                result.push_back(static_cast<char>(((cur[0] & 0x0F) << 12) | ((cur[1] & 0x3F) << 6) | (cur[2] & 0x3F)));
+                cur += 3;
+            } else {
+                result.push_back(static_cast<char>(((cur[0] & 0x07) << 18) | ((cur[1] & 0x3F) << 12) |
+                                                   ((cur[2] & 0x3F) << 6) | (cur[3] & 0x3F)));
+                cur += 4;
+            }
+        }
+        offset += length;
+        return result;
+    }
+}
+
+std::vector<std::string> make_corpus(const std::vector<std::string>& lines, std::size_t total_bytes) {
+    std::vector<std::string> corpus;
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; bytes < total_bytes; ++i) {
+        corpus.push_back(lines[i % lines.size()]);
+        bytes += corpus.back().size();
+    }
+    return corpus;
+}
+
+template<typename Func>
+double gib_per_second(std::size_t bytes, int repetitions, Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i) {
+        func();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(bytes) * repetitions / seconds / (1024.0 * 1024.0 * 1024.0);
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t corpus_bytes = (argc > 1 ? std::stoul(argv[1]) : 16) * 1024 * 1024;  // MiB per corpus
+    const int repetitions = 10;
+
+    const std::vector<std::string> ascii_lines = {
+            "Hey, is anyone around to review the connection pool change?",
+            "Sure, give me ten minutes and I'll take a look.",
+            "The benchmark numbers look good on my machine, 2.3 GB/s on the read path.",
+            "{\"type\":\"status\",\"user\":\"alice\",\"online\":true,\"rooms\":[\"general\",\"dev\"]}",
+    };
+    const std::vector<std::string> multilingual_lines = {
+            "Grüße aus München, bis später!",
+            "Привет, как дела? Всё хорошо.",
+            "こんにちは世界、今日はいい天気ですね。",
+            "你好，世界！我们明天见。",
+            "مرحبا بالعالم، كيف حالك؟",
+            "Ça va très bien, merci 😀🎉",
+            "The server restarted at 10:42 — no data lost.",
+    };
+
+    std::cout << "UTF-8 strings, " << corpus_bytes / (1024 * 1024) << " MiB per corpus, throughput in GiB/s\n\n";
+    std::cout << std::left << std::setw(16) << "corpus"
+              << std::setw(18) << "scalar validate"
+              << std::setw(18) << "is_valid_utf8"
+              << std::setw(20) << "legacy round trip"
+              << std::setw(20) << "passthrough" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (const auto& [name, lines] : {std::pair{"ascii", ascii_lines}, std::pair{"multilingual", multilingual_lines}}) {
+        auto corpus = make_corpus(lines, corpus_bytes);
+        std::string joined;
+        for (const auto& line : corpus) {
+            joined += line;
+        }
+        const auto* bytes = reinterpret_cast<const std::uint8_t*>(joined.data());
+        bool valid = true;
+
+        double scalar = gib_per_second(joined.size(), repetitions, [&]() {
+            valid &= FastVector::detail::validate_utf8_scalar(bytes, joined.size());
+        });
+        double validated = gib_per_second(joined.size(), repetitions, [&]() {
+            valid &= FastVector::is_valid_utf8(bytes, joined.size());
+        });
+
+        // Each line is serialized as a chat-sized string field and read back
+        std::size_t checksum = 0;
+        FastVector::ByteVector buffer;
+        double legacy = gib_per_second(joined.size(), 1, [&]() {
+            for (const auto& line : corpus) {
+                buffer.clear();
+                Legacy::append_string(buffer, line);
+                std::size_t offset = 0;
+                checksum += Legacy::read_string(buffer, offset).size();
+            }
+        });
+        double passthrough = gib_per_second(joined.size(), 1, [&]() {
+            for (const auto& line : corpus) {
+                buffer.clear();
+                NetworkMessages::BinaryData::append_bytes(buffer, line);
+                std::size_t offset = 0;
+                checksum += NetworkMessages::BinaryData::read_bytes<std::string>(buffer, offset).size();
+            }
+        });
+
+        if (!valid || checksum == 0) {
+            std::cout << "unexpected result for " << name << "\n";
+            return 1;
+        }
+        std::cout << std::left << std::setw(16) << name
+                  << std::setw(18) << scalar
+                  << std::setw(18) << validated
+                  << std::setw(20) << legacy
+                  << std::setw(20) << passthrough << "\n";
+    }
+
+    return 0;
+}
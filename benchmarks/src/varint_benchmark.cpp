@@ -0,0 +1,201 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BinaryData.h"
+#include "MessageSchema.h"
+#include "Varint.h"
+
+// The same record with fixed-width and varint integers
+struct Position {
+    std::uint32_t entity_id;
+    std::int32_t dx;
+    std::int32_t dy;
+    std::uint16_t sequence;
+    std::uint64_t timestamp_delta;
+    SERVERKIT_MESSAGE(Position, 50, entity_id, dx, dy, sequence, timestamp_delta)
+};
+
+struct CompactPosition {
+    std::uint32_t entity_id;
+    std::int32_t dx;
+    std::int32_t dy;
+    std::uint16_t sequence;
+    std::uint64_t timestamp_delta;
+    SERVERKIT_MESSAGE(CompactPosition, 51, entity_id, dx, dy, sequence, timestamp_delta)
+    SERVERKIT_INTEGER_ENCODING(Varint)
+};
+
+// Best of several runs, so page faults on the first touch of a buffer are not counted
+template<typename Func>
+double millis(Func&& func) {
+    double best = 0;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = run == 0 ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+std::vector<std::uint64_t> make_values(const std::string& distribution, std::size_t count) {
+    std::mt19937_64 rng(42);
+    std::vector<std::uint64_t> values(count);
+    for (auto& value : values) {
+        if (distribution == "small (<128)") {
+            value = rng() % 128;
+        } else if (distribution == "medium (<16K)") {
+            value = rng() % 16384;
+        } else if (distribution == "zigzag +-1000") {
+            value = FastVector::zigzag_encode(static_cast<std::int64_t>(rng() % 2001) - 1000);
+        } else {
+            value = rng() >> (rng() % 64);  // Uniform bit length, up to 10 bytes
+        }
+    }
+    return values;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    bool ok = true;
+
+    std::cout << count << " uint64 values per distribution; size in bytes per value, time in ms\n\n";
+    std::cout << std::left << std::setw(18) << "distribution" << std::setw(10) << "fixed B" << std::setw(10) << "varint B"
+              << std::setw(14) << "fixed enc" << std::setw(14) << "varint enc"
+              << std::setw(14) << "fixed dec" << std::setw(14) << "loop dec" << std::setw(14) << "varint dec"
+              << std::setw(14) << "batch dec" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (const std::string distribution : {"small (<128)", "medium (<16K)", "zigzag +-1000", "wide"}) {
+        auto values = make_values(distribution, count);
+        std::vector<std::uint64_t> decoded(count);
+
+        FastVector::ByteVector fixed;
+        fixed.resize_uninitialized(count * sizeof(std::uint64_t));
+        double fixed_encode = millis([&]() {
+            FastVector::ByteWriter writer(fixed.data(), fixed.size());
+            for (auto value : values) {
+                writer.write(value);
+            }
+        });
+
+        std::size_t varint_bytes = 0;
+        for (auto value : values) {
+            varint_bytes += FastVector::varint_size(value);
+        }
+        FastVector::ByteVector varint;
+        varint.resize_uninitialized(varint_bytes);
+        double varint_encode = millis([&]() {
+            FastVector::ByteWriter writer(varint.data(), varint.size());
+            for (auto value : values) {
+                FastVector::write_varint(writer, value);
+            }
+        });
+
+        double fixed_decode = millis([&]() {
+            FastVector::ByteReader reader(fixed);
+            for (auto& value : decoded) {
+                value = reader.read<std::uint64_t>();
+            }
+        });
+        ok &= decoded == values;
+
+        // The textbook byte-at-a-time loop as a baseline for decode_varint
+        std::fill(decoded.begin(), decoded.end(), 0);
+        double loop_decode = millis([&]() {
+            const std::uint8_t* p = varint.data();
+            for (auto& value : decoded) {
+                std::uint64_t result = 0;
+                int shift = 0;
+                while (*p & 0x80) {
+                    result |= static_cast<std::uint64_t>(*p++ & 0x7F) << shift;
+                    shift += 7;
+                }
+                value = result | static_cast<std::uint64_t>(*p++) << shift;
+            }
+        });
+        ok &= decoded == values;
+
+        std::fill(decoded.begin(), decoded.end(), 0);
+        double varint_decode = millis([&]() {
+            FastVector::ByteReader reader(varint);
+            for (auto& value : decoded) {
+                value = FastVector::read_varint(reader);
+            }
+        });
+        ok &= decoded == values;
+
+        std::fill(decoded.begin(), decoded.end(), 0);
+        double batch_decode = millis([&]() {
+            FastVector::decode_varints(varint.data(), varint.size(), decoded.data(), decoded.size());
+        });
+        ok &= decoded == values;
+
+        std::cout << std::left << std::setw(18) << distribution
+                  << std::setw(10) << static_cast<double>(fixed.size()) / count
+                  << std::setw(10) << static_cast<double>(varint.size()) / count
+                  << std::setw(14) << fixed_encode << std::setw(14) << varint_encode
+                  << std::setw(14) << fixed_decode << std::setw(14) << loop_decode
+                  << std::setw(14) << varint_decode << std::setw(14) << batch_decode << "\n";
+    }
+
+    // Whole messages through MessageCodec, both encodings of the same records
+    std::mt19937 rng(7);
+    std::vector<Position> positions(count);
+    std::vector<CompactPosition> compact(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        positions[i] = {static_cast<std::uint32_t>(rng() % 5000), static_cast<std::int32_t>(rng() % 41) - 20,
+                        static_cast<std::int32_t>(rng() % 41) - 20, static_cast<std::uint16_t>(i), 16 + rng() % 8};
+        compact[i] = {positions[i].entity_id, positions[i].dx, positions[i].dy, positions[i].sequence, positions[i].timestamp_delta};
+    }
+
+    auto run = [&](auto& records, std::size_t& wire_bytes, double& encode, double& decode) {
+        using Record = typename std::remove_reference_t<decltype(records)>::value_type;
+        using Codec = NetworkMessages::MessageCodec<Record>;
+        wire_bytes = 0;
+        for (const auto& record : records) {
+            wire_bytes += Codec::size(record);
+        }
+        FastVector::ByteVector buffer;
+        buffer.resize_uninitialized(wire_bytes);
+        encode = millis([&]() {
+            FastVector::ByteWriter writer(buffer.data(), buffer.size());
+            for (const auto& record : records) {
+                Codec::write(writer, record);
+            }
+        });
+        std::vector<Record> out(records.size());
+        decode = millis([&]() {
+            FastVector::ByteReader reader(buffer);
+            for (auto& record : out) {
+                Codec::read(reader, record);
+            }
+        });
+        for (std::size_t i = 0; i < records.size(); ++i) {
+            ok &= out[i].entity_id == records[i].entity_id && out[i].dy == records[i].dy &&
+                  out[i].timestamp_delta == records[i].timestamp_delta;
+        }
+    };
+    std::size_t fixed_bytes, varint_bytes;
+    double fixed_encode, fixed_decode, varint_encode, varint_decode;
+    run(positions, fixed_bytes, fixed_encode, fixed_decode);
+    run(compact, varint_bytes, varint_encode, varint_decode);
+
+    if (!ok) {
+        std::cout << "Round trips do not match\n";
+        return 1;
+    }
+
+    std::cout << "\n" << count << " position messages, time in ms\n\n";
+    std::cout << std::left << std::setw(18) << "encoding" << std::setw(16) << "bytes/message" << std::setw(12) << "encode" << std::setw(12) << "decode" << "\n";
+    std::cout << std::left << std::setw(18) << "Fixed" << std::setw(16) << static_cast<double>(fixed_bytes) / count
+              << std::setw(12) << fixed_encode << std::setw(12) << fixed_decode << "\n";
+    std::cout << std::left << std::setw(18) << "Varint" << std::setw(16) << static_cast<double>(varint_bytes) / count
+              << std::setw(12) << varint_encode << std::setw(12) << varint_decode << "\n";
+    return 0;
+}
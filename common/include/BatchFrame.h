@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "ByteSpan.h"
+#include "ByteVector.h"
+#include "FrameHeader.h"
+#include "Varint.h"
+
+
+namespace NetworkMessages
+{
+
+// Sender-side coalescing settings for a TCP connection. Config keys, read by
+// TCPServerBase and TCPClientBase:
+//   batch_frames        send batch frames when the peer supports them (default false)
+//   batch_max_bytes     flush once a batch holds this many bytes (default 16384)
+//   batch_max_delay_us  flush at the latest this long after the first message, 0 to
+//                       flush once the current burst of writes is queued (default 200)
+//   max_frame_bytes     close the connection on a larger incoming frame (default 64 MiB)
+struct BatchOptions {
+    bool enabled = false;
+    std::size_t max_bytes = 16 * 1024;
+    std::chrono::microseconds max_delay{200};
+};
+
+// Packs many small messages into one TCP frame. A batch frame sets the top bit of the
+// 4-byte size header (see FrameHeader.h); its payload is each message prefixed with its
+// length as a varint. An empty batch frame is the hello a connection sends when batching
+// is enabled: a peer only batches after it has received one. A peer built before batch
+// frames existed reads the hello as a 2 GiB plain frame, so batch_frames must only be
+// enabled on a client whose server understands it; servers answer hellos rather than
+// sending their own (see Connection::HelloRole).
+class BatchFrame
+{
+public:
+    static constexpr std::uint32_t FLAG = FrameHeader::BATCH_FLAG;
+
+    static bool isBatch(std::uint32_t header) { return (header & FLAG) != 0; }
+
+    static std::uint32_t header(std::size_t payload_size)
+    {
+        if (payload_size > FrameHeader::SIZE_MASK)
+        {
+            throw std::runtime_error("Batch frame too large");
+        }
+        return FLAG | static_cast<std::uint32_t>(payload_size);
+    }
+
+    // Appends the length prefix of a message_size-byte message; the caller appends the bytes
+    template<std::size_t InlineN>
+    static void appendMessageHeader(FastVector::BasicByteVector<InlineN>& batch, std::size_t message_size)
+    {
+        std::uint8_t prefix[FastVector::MAX_VARINT_BYTES];
+        std::size_t length = FastVector::encode_varint(message_size, prefix);
+        batch.insert(batch.end(), prefix, prefix + length);
+    }
+
+    template<std::size_t InlineN>
+    static void append(FastVector::BasicByteVector<InlineN>& batch, FastVector::ByteSpan message)
+    {
+        appendMessageHeader(batch, message.size());
+        batch.insert(batch.end(), message.begin(), message.end());
+    }
+
+    // Checks the whole payload and returns its message count; throws std::runtime_error
+    // if a length prefix is malformed or runs past the end
+    static std::size_t count(FastVector::ByteSpan payload)
+    {
+        std::size_t messages = 0;
+        forEach(payload, [&messages](FastVector::ByteSpan) { ++messages; });
+        return messages;
+    }
+
+    // Calls callback(ByteSpan) for each message in the payload, in order
+    template<typename Callback>
+    static void forEach(FastVector::ByteSpan payload, Callback&& callback)
+    {
+        FastVector::ByteReader reader(payload);
+        while (!reader.atEnd())
+        {
+            std::uint64_t length = FastVector::read_varint(reader);
+            if (length > reader.remaining())
+            {
+                throw std::runtime_error("Batched message runs past the end of the frame");
+            }
+            callback(reader.readBytes(static_cast<std::size_t>(length)));
+        }
+    }
+};
+
+}
@@ -6,8 +6,15 @@
 #include <memory>
 #include <stdexcept>
 #include <cstdint>
+#include <cstring>
 
 #include "ByteVector.h"
+#include "ByteSpan.h"
+#include "ByteWriter.h"
+#include "FrameHeader.h"
+#include "Utf8.h"
+#include "Varint.h"
+#include "MessageSchema.h"
 
 namespace NetworkMessages
 {
@@ -22,15 +29,67 @@ namespace NetworkMessages
         // Serialize the message to a byte vector
         [[nodiscard]] virtual ByteVector serialize() const = 0;
 
-        // Deserialize from a byte vector
-        virtual void deserialize(const ByteVector &data, size_t& offset) = 0;
+        // Deserialize from any contiguous bytes, starting at offset; ByteVector, SharedBuffer
+        // and sub-ranges of larger buffers all convert to ByteSpan without copying
+        virtual void deserialize(FastVector::ByteSpan data, size_t& offset) = 0;
 
-        // Serialization helpers
-        template<typename T>
-        static void append_bytes(ByteVector &vec, const T &data)
+        // Exact number of bytes serialize() produces. The default serializes to find out;
+        // override it together with serializeInto() so frames are built in a single pass.
+        [[nodiscard]] virtual size_t serializedSize() const
+        {
+            return serialize().size();
+        }
+
+        // Writes the serialized form into writer, which must have serializedSize() bytes left
+        virtual void serializeInto(FastVector::ByteWriter &writer) const
+        {
+            auto bytes = serialize();
+            writer.writeBytes(bytes.data(), bytes.size());
+        }
+
+        // The complete TCP frame, 4-byte little-endian length prefix included, written into
+        // one buffer sized up front. Send it with Session::writeFrame().
+        [[nodiscard]] ByteVector serializeFrame() const
+        {
+            size_t payload_size = serializedSize();
+            if (payload_size > FrameHeader::SIZE_MASK)
+            {
+                throw std::runtime_error("Frame too large");
+            }
+            ByteVector frame;
+            frame.resize_uninitialized(sizeof(uint32_t) + payload_size);
+            FastVector::ByteWriter writer(frame.data(), frame.size());
+            writer.write(static_cast<uint32_t>(payload_size));
+            serializeInto(writer);
+            if (writer.remaining() != 0)
+            {
+                throw std::runtime_error("serializeInto() wrote fewer bytes than serializedSize()");
+            }
+            return frame;
+        }
+
+        // Serialization helpers; the destination may use any inline capacity. Besides
+        // scalars, strings and ByteVector they take Varint<T> and the containers
+        // MessageSchema supports (vector, array, optional, map), encoded the same way.
+        template<typename T, std::size_t InlineN>
+        static void append_bytes(FastVector::BasicByteVector<InlineN> &vec, const T &data)
         {
-            if constexpr (std::is_same_v<T, ByteVector>) {
+            if constexpr (std::is_same_v<T, std::string>) {
+                std::size_t size = sizeof(uint32_t) + data.size();
+                FastVector::ByteWriter writer(vec.append_uninitialized(size).data(), size);
+                write_string(writer, data);
+                vec.commit(size);
+            } else if constexpr (std::is_same_v<T, ByteVector>) {
                 append_byte_vector(vec, data);
+            } else if constexpr (is_varint_v<T>) {
+                byte encoded[FastVector::MAX_VARINT_BYTES];
+                std::size_t length = FastVector::encode_varint(FastVector::to_varint_bits(data.value), encoded);
+                vec.insert(vec.end(), encoded, encoded + length);
+            } else if constexpr (is_container_field_v<T>) {
+                std::size_t size = FieldCodec<T>::size(data);
+                FastVector::ByteWriter writer(vec.append_uninitialized(size).data(), size);
+                FieldCodec<T>::write(writer, data);
+                vec.commit(size);
             } else
             {
                 auto bytes = to_bytes(data);
@@ -39,47 +98,113 @@ namespace NetworkMessages
 
         }
 
+        // Received strings are checked for well-formed UTF-8 unless this is turned off,
+        // e.g. when every peer is trusted; shared with the MessageSchema codecs
+        static void set_validate_utf8(bool enabled)
+        {
+            FastVector::set_utf8_validation(enabled);
+        }
+
+        static bool validate_utf8()
+        {
+            return FastVector::utf8_validation_enabled();
+        }
+
+        // Encoded size of a value as written by append_bytes/write_bytes
         template<typename T>
-        static T read_bytes(const ByteVector& data, size_t& offset)
+        static size_t byte_size(const T &data)
+        {
+            if constexpr (std::is_same_v<T, std::string>) {
+                return sizeof(uint32_t) + data.size();
+            } else if constexpr (std::is_same_v<T, ByteVector>) {
+                return data.size();
+            } else if constexpr (is_varint_v<T>) {
+                return FastVector::varint_size(FastVector::to_varint_bits(data.value));
+            } else if constexpr (is_container_field_v<T>) {
+                return FieldCodec<T>::size(data);
+            } else
+            {
+                return sizeof(T);
+            }
+        }
+
+        // Writes a value in the same encoding as append_bytes, without temporaries
+        template<typename T>
+        static void write_bytes(FastVector::ByteWriter &writer, const T &data)
+        {
+            if constexpr (std::is_same_v<T, std::string>) {
+                write_string(writer, data);
+            } else if constexpr (std::is_same_v<T, ByteVector>) {
+                writer.writeBytes(data.data(), data.size());
+            } else if constexpr (is_varint_v<T>) {
+                FastVector::write_varint(writer, FastVector::to_varint_bits(data.value));
+            } else if constexpr (is_container_field_v<T>) {
+                FieldCodec<T>::write(writer, data);
+            } else
+            {
+                writer.write(data);
+            }
+        }
+
+        template<typename T>
+        static T read_bytes(FastVector::ByteSpan data, size_t& offset)
         {
            if constexpr (std::is_same_v<T, std::string>) {
                 return read_string_from_bytes(data, offset);
+            } else if constexpr (is_varint_v<T>) {
+                std::uint64_t bits = 0;
+                std::size_t consumed = offset > data.size() ? 0
+                        : FastVector::decode_varint(data.data() + offset, data.size() - offset, bits);
+                if (consumed == 0)
+                {
+                    throw std::runtime_error("Invalid or truncated varint");
+                }
+                offset += consumed;
+                return T(FastVector::from_varint_bits<typename T::value_type>(bits));
+            } else if constexpr (is_container_field_v<T>) {
+                FastVector::ByteReader reader(data, offset);
+                T value{};
+                FieldCodec<T>::read(reader, value);
+                offset = reader.position();
+                return value;
             } else
             {
-                if (offset + sizeof(T) > data.size())
+                if (offset > data.size() || sizeof(T) > data.size() - offset)
                 {
                     throw std::runtime_error("Not enough data to read");
                 }
 
-                // Check if the offset and sizeof(T) are too large for the system's ptrdiff_t
-                if (offset + sizeof(T) > static_cast<size_t>(std::numeric_limits<std::ptrdiff_t>::max()))
-                {
-                    throw std::runtime_error("Data size too large for this system");
-                }
-
-                // Use ptrdiff_t for iterator arithmetic
-                auto start = data.begin() + static_cast<std::ptrdiff_t>(offset);
-                auto end = start + static_cast<std::ptrdiff_t>(sizeof(T));
-
-                T value = from_bytes<T>(ByteVector(start, end));
-                from_network_order(value);  // Convert from network byte order to host byte order
+                // Decode straight from the buffer; load_little_endian does the only byte-order fix
+                T value = FastVector::load_little_endian<T>(data.data() + offset);
                 offset += sizeof(T);
                 return value;
             }
         }
 
-    private:
-        // Convert network order helpers
+        // Reads count varints written back to back with append_bytes(Varint<T>) in one pass
         template<typename T>
-        static void to_network_order(T& value) {
-            if (!is_little_endian()) {
-                char* p = reinterpret_cast<char*>(&value);
-                std::reverse(p, p + sizeof(T));
-            }
+        static void read_varints(FastVector::ByteSpan data, size_t& offset, T* out, std::size_t count)
+        {
+            FastVector::ByteReader reader(data, offset);
+            FastVector::read_varints(reader, out, count);
+            offset = reader.position();
+        }
+
+    protected:
+        // serialize() for classes that override serializedSize() and serializeInto()
+        [[nodiscard]] ByteVector serialize_single_pass() const
+        {
+            ByteVector data;
+            data.resize_uninitialized(serializedSize());
+            FastVector::ByteWriter writer(data.data(), data.size());
+            serializeInto(writer);
+            return data;
         }
 
+    private:
+        // Convert network order helpers
         template<typename T>
-        static void from_network_order(T& value) {
+        static void to_network_order(T& value) {
             if (!is_little_endian()) {
                 char* p = reinterpret_cast<char*>(&value);
                 std::reverse(p, p + sizeof(T));
@@ -92,117 +217,57 @@ namespace NetworkMessages
         }
 
         template<typename T>
-        static ByteVector to_bytes(const T& object) {
-            if constexpr (std::is_same_v<T, std::string>) {
-                return string_to_bytes(object);
-            } else {
-                static_assert(std::is_trivially_copyable<T>::value, "not a TriviallyCopyable type");
-                ByteVector bytes;
-                bytes.reserve(sizeof(T));  // Reserve space but don't initialize
-                T network_object = object;
-                to_network_order(network_object);
-                const byte* begin = reinterpret_cast<const byte*>(std::addressof(network_object));
-                const byte* end = begin + sizeof(T);
-                bytes.insert(bytes.end(), begin, end);  // Use insert instead of std::copy
-                return bytes;
-            }
-        }
-
-        template<typename T>
-        static T from_bytes(const ByteVector& bytes) {
+        static auto to_bytes(const T& object) {
             static_assert(std::is_trivially_copyable<T>::value, "not a TriviallyCopyable type");
-            T object;
-            std::memcpy(&object, bytes.data(), sizeof(T));
-            from_network_order(object);
-            return object;
+            FastVector::TinyByteVector bytes;
+            bytes.reserve(sizeof(T));  // Reserve space but don't initialize
+            T network_object = object;
+            to_network_order(network_object);
+            const byte* begin = reinterpret_cast<const byte*>(std::addressof(network_object));
+            const byte* end = begin + sizeof(T);
+            bytes.insert(bytes.end(), begin, end);  // Use insert instead of std::copy
+            return bytes;
         }
 
-        static void append_byte_vector(ByteVector &vec, const ByteVector &data)
+        template<std::size_t InlineN>
+        static void append_byte_vector(FastVector::BasicByteVector<InlineN> &vec, const ByteVector &data)
         {
             vec.insert(vec.end(), data.begin(), data.end());
         }
-        static ByteVector read_byte_vector(const ByteVector& data, size_t& offset)
+        static ByteVector read_byte_vector(FastVector::ByteSpan data, size_t& offset)
         {
             auto size = read_bytes<uint32_t>(data, offset);
-            ByteVector vec;
-            vec.reserve(size);
-            vec.insert(vec.end(), data.begin() + offset, data.begin() + offset + size);
+            if (size > data.size() - offset)
+            {
+                throw std::runtime_error("Not enough data to read byte vector");
+            }
+            ByteVector vec(data.begin() + offset, data.begin() + offset + size);
             offset += size;
             return vec;
         }
-        static ByteVector string_to_bytes(const std::string& str) {
-            ByteVector bytes;
-            bytes.reserve(sizeof(uint32_t) + str.size() * 4);  // Worst case: all 4-byte UTF-8
-
-            uint32_t utf8_length = 0;
-            for (char32_t c : str) {
-                if (c <= 0x7F) {
-                    utf8_length += 1;
-                    bytes.push_back(static_cast<byte>(c));
-                } else if (c <= 0x7FF) {
-                    utf8_length += 2;
-                    bytes.push_back(static_cast<byte>(0xC0 | (c >> 6)));
-                    bytes.push_back(static_cast<byte>(0x80 | (c & 0x3F)));
-                } else if (c <= 0xFFFF) {
-                    utf8_length += 3;
-                    bytes.push_back(static_cast<byte>(0xE0 | (c >> 12)));
-                    bytes.push_back(static_cast<byte>(0x80 | ((c >> 6) & 0x3F)));
-                    bytes.push_back(static_cast<byte>(0x80 | (c & 0x3F)));
-                } else {
-                    utf8_length += 4;
-                    bytes.push_back(static_cast<byte>(0xF0 | (c >> 18)));
-                    bytes.push_back(static_cast<byte>(0x80 | ((c >> 12) & 0x3F)));
-                    bytes.push_back(static_cast<byte>(0x80 | ((c >> 6) & 0x3F)));
-                    bytes.push_back(static_cast<byte>(0x80 | (c & 0x3F)));
-                }
-            }
-
-            ByteVector result;
-            result.reserve(sizeof(uint32_t) + utf8_length);
-            append_bytes(result, utf8_length);
-            result.insert(result.end(), bytes.begin(), bytes.end());
-            return result;
+        // Strings go on the wire as a uint32 byte count followed by the bytes unchanged;
+        // they are expected to hold UTF-8 already
+        static void write_string(FastVector::ByteWriter& writer, const std::string& str) {
+            writer.write(static_cast<uint32_t>(str.size()));
+            writer.writeBytes(str.data(), str.size());
         }
 
-        static std::string read_string_from_bytes(const ByteVector& data, size_t& offset) {
-            if (offset + sizeof(uint32_t) > data.size()) {
+        static std::string read_string_from_bytes(FastVector::ByteSpan data, size_t& offset) {
+            if (offset > data.size() || sizeof(uint32_t) > data.size() - offset) {
                 throw std::runtime_error("Not enough data to read string length");
             }
 
             auto utf8_length = read_bytes<uint32_t>(data, offset);
 
-            if (offset + utf8_length > data.size()) {
+            if (utf8_length > data.size() - offset) {
                 throw std::runtime_error("Not enough data to read string content");
             }
 
-            std::string result;
-            result.reserve(utf8_length);  // Pre-allocate for efficiency
-            const byte* cur = data.data() + offset;
-            const byte* end = cur + utf8_length;
-
-            while (cur < end) {
-                if ((*cur & 0x80) == 0) {
-                    result.push_back(static_cast<char>(*cur++));
-                } else if ((*cur & 0xE0) == 0xC0) {
-                    if (end - cur < 2) throw std::runtime_error("Invalid UTF-8 sequence");
-                    char32_t codepoint = ((cur[0] & 0x1F) << 6) | (cur[1] & 0x3F);
-                    result.push_back(static_cast<char>(codepoint));
-                    cur += 2;
-                } else if ((*cur & 0xF0) == 0xE0) {
-                    if (end - cur < 3) throw std::runtime_error("Invalid UTF-8 sequence");
-                    char32_t codepoint = ((cur[0] & 0x0F) << 12) | ((cur[1] & 0x3F) << 6) | (cur[2] & 0x3F);
-                    result.push_back(static_cast<char>(codepoint));
-                    cur += 3;
-                } else if ((*cur & 0xF8) == 0xF0) {
-                    if (end - cur < 4) throw std::runtime_error("Invalid UTF-8 sequence");
-                    char32_t codepoint = ((cur[0] & 0x07) << 18) | ((cur[1] & 0x3F) << 12) |
-                                         ((cur[2] & 0x3F) << 6) | (cur[3] & 0x3F);
-                    result.push_back(static_cast<char>(codepoint));
-                    cur += 4;
-                } else {
-                    throw std::runtime_error("Invalid UTF-8 sequence");
-                }
+            const byte* content = data.data() + offset;
+            if (validate_utf8() && !FastVector::is_valid_utf8(content, utf8_length)) {
+                throw std::runtime_error("Invalid UTF-8 sequence");
             }
+            std::string result(reinterpret_cast<const char*>(content), utf8_length);
 
             offset += utf8_length;
             return result;
@@ -217,50 +282,90 @@ namespace NetworkMessages
 
         [[nodiscard]] ByteVector serialize() const override
         {
-            ByteVector data;
-            append_bytes(data, Type);
-            return data;
+            return serialize_single_pass();
+        }
+
+        [[nodiscard]] size_t serializedSize() const override
+        {
+            return sizeof(Type);
+        }
+
+        void serializeInto(FastVector::ByteWriter &writer) const override
+        {
+            write_bytes(writer, Type);
         }
 
-        void deserialize(const ByteVector &data, size_t& offset) override
+        void deserialize(FastVector::ByteSpan data, size_t& offset) override
         {
             Type = read_bytes<short>(data, offset);
         }
 
     };
 
+    // T either inherits from BinaryData or declares a SERVERKIT_MESSAGE schema. Schema
+    // payloads are encoded by MessageCodec<T> directly, with no virtual calls.
     template<typename T>
     class BinaryMessage : public BinaryData
     {
+        static_assert(std::is_base_of_v<BinaryData, T> || ReflectedMessage<T>,
+                      "T must inherit from BinaryData or declare SERVERKIT_MESSAGE");
+
     public:
         BinaryMessage(short messageType, const T &payload)
                 : messageType(messageType), messagePayload(payload)
         {
-            static_assert(std::is_base_of_v<BinaryData, T>, "T must inherit from BinaryData");
         }
 
+        // Uses the type ID from the payload's schema
+        explicit BinaryMessage(const T &payload) requires ReflectedMessage<T>
+                : messageType(T::MessageTypeId), messagePayload(payload)
+        {
+        }
+
+        // Type and payload are written into one buffer sized up front
         [[nodiscard]] ByteVector serialize() const override
         {
-            ByteVector data;
-            MessageTypeData typeData;
-            typeData.Type = messageType;
-            auto messageTypeData = typeData.serialize();
-            data.insert(data.end(), messageTypeData.begin(), messageTypeData.end());
-            auto payloadData = messagePayload.serialize();
-            data.insert(data.end(), payloadData.begin(), payloadData.end());
-            return data;
+            return serialize_single_pass();
+        }
+
+        [[nodiscard]] size_t serializedSize() const override
+        {
+            if constexpr (ReflectedMessage<T>) {
+                return sizeof(short) + MessageCodec<T>::size(messagePayload);
+            } else
+            {
+                return sizeof(short) + messagePayload.serializedSize();
+            }
         }
 
-        void deserialize(const ByteVector &data, size_t &offset) override
+        void serializeInto(FastVector::ByteWriter &writer) const override
         {
-            if (data.size() - offset < sizeof(short))
+            write_bytes(writer, messageType);
+            if constexpr (ReflectedMessage<T>) {
+                MessageCodec<T>::write(writer, messagePayload);
+            } else
+            {
+                messagePayload.serializeInto(writer);
+            }
+        }
+
+        void deserialize(FastVector::ByteSpan data, size_t &offset) override
+        {
+            if (offset > data.size() || data.size() - offset < sizeof(short))
             {
                 throw std::runtime_error("Invalid data: too short to contain message type");
             }
             MessageTypeData typeData;
             typeData.deserialize(data, offset);
             messageType = typeData.Type;
-            messagePayload.deserialize(data, offset);
+            if constexpr (ReflectedMessage<T>) {
+                FastVector::ByteReader reader(data, offset);
+                MessageCodec<T>::read(reader, messagePayload);
+                offset = reader.position();
+            } else
+            {
+                messagePayload.deserialize(data, offset);
+            }
         }
 
         [[nodiscard]] short getMessageType() const { return messageType; }
@@ -280,12 +385,20 @@ namespace NetworkMessages
 
         [[nodiscard]] ByteVector serialize() const override
         {
-            ByteVector data;
-            append_bytes(data, ErrorMessage);
-            return data;
+            return serialize_single_pass();
+        }
+
+        [[nodiscard]] size_t serializedSize() const override
+        {
+            return byte_size(ErrorMessage);
+        }
+
+        void serializeInto(FastVector::ByteWriter &writer) const override
+        {
+            write_bytes(writer, ErrorMessage);
         }
 
-        void deserialize(const ByteVector &data, size_t &offset) override
+        void deserialize(FastVector::ByteSpan data, size_t &offset) override
         {
             ErrorMessage = read_bytes<std::string>(data, offset);
         }
@@ -302,7 +415,7 @@ namespace NetworkMessages
             return std::make_unique<BinaryMessage<T>>(type, payload);
         }
 
-        static short getMessageTypeFromBytes(const FastVector::ByteVector &data)
+        static short getMessageTypeFromBytes(FastVector::ByteSpan data)
         {
             if (data.size() < sizeof(short))
             {
@@ -318,7 +431,7 @@ namespace NetworkMessages
     private:
         template<typename T>
         static std::unique_ptr<BinaryMessage<T>>
-        createAndDeserialize(short type, const std::vector<BinaryData::byte> &data)
+        createAndDeserialize(short type, FastVector::ByteSpan data)
         {
             auto message = std::make_unique<BinaryMessage<T>>(type, T{});
             size_t offset = 0;
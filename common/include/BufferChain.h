@@ -0,0 +1,223 @@
+#pragma once
+
+#include <asio/buffer.hpp>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "ByteVector.h"
+#include "SharedBuffer.h"
+
+
+namespace FastVector
+{
+
+// Ordered list of byte segments written out with a single scatter/gather call.
+//
+// Every segment owns or shares its bytes: short literals such as a length prefix are
+// stored inside the segment, byte vectors and strings are moved in, and SharedBuffers
+// are referenced. A frame can therefore be assembled from a small header and an
+// existing payload without copying the payload into a contiguous buffer.
+//
+// The first INLINE_SEGMENTS segments live inside the chain itself; longer chains spill
+// into a heap vector. buffers() returns a cheap, copyable view that satisfies asio's
+// ConstBufferSequence requirements and stays valid as long as the chain is neither
+// modified nor moved, e.g. while it sits at the front of a write queue.
+class BufferChain {
+public:
+    using size_type = std::size_t;
+
+    static constexpr size_type INLINE_SEGMENTS = 4;
+    static constexpr size_type INLINE_BYTES = 16;  // Largest segment stored inside the chain
+
+    class Segment {
+    public:
+        const std::uint8_t* data() const {
+            return std::visit([](const auto& storage) { return storage_data(storage); }, storage_);
+        }
+
+        size_type size() const {
+            return std::visit([](const auto& storage) { return storage.size(); }, storage_);
+        }
+
+        operator asio::const_buffer() const { return {data(), size()}; }
+
+        // The buffer this segment references, or nullptr if the segment owns its bytes
+        const SharedBuffer* shared() const { return std::get_if<SharedBuffer>(&storage_); }
+
+    private:
+        friend class BufferChain;
+
+        struct InlineBytes {
+            std::array<std::uint8_t, INLINE_BYTES> bytes;
+            std::uint8_t length;
+            size_type size() const { return length; }
+        };
+
+        static const std::uint8_t* storage_data(const InlineBytes& storage) { return storage.bytes.data(); }
+        static const std::uint8_t* storage_data(const HeapByteVector& storage) { return storage.data(); }
+        static const std::uint8_t* storage_data(const SharedBuffer& storage) { return storage.data(); }
+        static const std::uint8_t* storage_data(const std::string& storage) {
+            return reinterpret_cast<const std::uint8_t*>(storage.data());
+        }
+
+        std::variant<InlineBytes, HeapByteVector, SharedBuffer, std::string> storage_;
+    };
+
+    // Lightweight view over the segments, passed to asio::async_write
+    class View {
+    public:
+        using value_type = Segment;
+        using const_iterator = const Segment*;
+
+        View(const Segment* first, const Segment* last) : first_(first), last_(last) {}
+
+        const_iterator begin() const { return first_; }
+        const_iterator end() const { return last_; }
+
+    private:
+        const Segment* first_;
+        const Segment* last_;
+    };
+
+    BufferChain() = default;
+
+    // Takes over the segments of other and leaves it empty
+    BufferChain(BufferChain&& other) noexcept
+        : inline_segments_(std::move(other.inline_segments_)),
+          overflow_(std::move(other.overflow_)),
+          segment_count_(other.segment_count_),
+          total_size_(other.total_size_) {
+        other.clear();
+    }
+
+    BufferChain& operator=(BufferChain&& other) noexcept {
+        if (this != &other) {
+            inline_segments_ = std::move(other.inline_segments_);
+            overflow_ = std::move(other.overflow_);
+            segment_count_ = other.segment_count_;
+            total_size_ = other.total_size_;
+            other.clear();
+        }
+        return *this;
+    }
+
+    BufferChain(const BufferChain&) = delete;
+    BufferChain& operator=(const BufferChain&) = delete;
+
+    // Copies a few bytes into the chain, e.g. a length prefix or a delimiter. Anything
+    // longer than INLINE_BYTES is copied into a pool-backed vector instead.
+    void appendCopy(const void* data, size_type size) {
+        if (size == 0) return;
+        if (size <= INLINE_BYTES) {
+            Segment::InlineBytes bytes{};
+            std::memcpy(bytes.bytes.data(), data, size);
+            bytes.length = static_cast<std::uint8_t>(size);
+            push(std::move(bytes));
+        } else {
+            auto* first = static_cast<const std::uint8_t*>(data);
+            push(HeapByteVector(first, first + size));
+        }
+    }
+
+    template<std::size_t InlineN>
+    void append(BasicByteVector<InlineN>&& bytes) {
+        if (bytes.empty()) return;
+        if (bytes.size() <= INLINE_BYTES) {
+            appendCopy(bytes.data(), bytes.size());
+        } else {
+            push(HeapByteVector(std::move(bytes)));
+        }
+    }
+
+    void append(SharedBuffer bytes) {
+        if (bytes.empty()) return;
+        push(std::move(bytes));
+    }
+
+    void append(std::string&& text) {
+        if (text.empty()) return;
+        if (text.size() <= INLINE_BYTES) {
+            appendCopy(text.data(), text.size());
+        } else {
+            push(std::move(text));
+        }
+    }
+
+    // Moves the segments of other to the end of this chain and leaves other empty
+    void append(BufferChain&& other) {
+        Segment* first = other.overflow_.empty() ? other.inline_segments_.data() : other.overflow_.data();
+        for (size_type i = 0; i < other.segment_count_; ++i) {
+            push(std::move(first[i].storage_));
+        }
+        other.clear();
+    }
+
+    // Drops all segments, releasing owned bytes and shared references
+    void clear() {
+        for (Segment& segment : inline_segments_) {
+            segment = Segment();
+        }
+        overflow_.clear();
+        segment_count_ = 0;
+        total_size_ = 0;
+    }
+
+    // Total number of bytes across all segments
+    size_type size() const { return total_size_; }
+    bool empty() const { return total_size_ == 0; }
+    size_type segmentCount() const { return segment_count_; }
+
+    const Segment* begin() const { return segments(); }
+    const Segment* end() const { return segments() + segment_count_; }
+
+    View buffers() const { return View(begin(), end()); }
+
+    // Copies all segments into one contiguous vector, for callers that need flat bytes
+    ByteVector flatten() const {
+        ByteVector result;
+        result.reserve(total_size_);
+        for (const Segment& segment : *this) {
+            result.insert(result.end(), segment.data(), segment.data() + segment.size());
+        }
+        return result;
+    }
+
+private:
+    const Segment* segments() const {
+        return overflow_.empty() ? inline_segments_.data() : overflow_.data();
+    }
+
+    template<typename Storage>
+    void push(Storage&& storage) {
+        Segment segment;
+        segment.storage_ = std::forward<Storage>(storage);
+        total_size_ += segment.size();
+
+        if (segment_count_ < INLINE_SEGMENTS) {
+            inline_segments_[segment_count_++] = std::move(segment);
+            return;
+        }
+        if (overflow_.empty()) {
+            // Spill: move the inline segments over so the view stays contiguous
+            overflow_.reserve(INLINE_SEGMENTS * 2);
+            for (Segment& inline_segment : inline_segments_) {
+                overflow_.push_back(std::move(inline_segment));
+            }
+        }
+        overflow_.push_back(std::move(segment));
+        ++segment_count_;
+    }
+
+    std::array<Segment, INLINE_SEGMENTS> inline_segments_;
+    std::vector<Segment> overflow_;
+    size_type segment_count_ = 0;
+    size_type total_size_ = 0;
+};
+
+
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "ByteVector.h"
+#include "ByteWriter.h"
+#include "SharedBuffer.h"
+
+
+namespace FastVector
+{
+
+// Non-owning, read-only view of contiguous bytes. Converts implicitly from every byte
+// container in the tree, so decoding code can take a ByteSpan and accept a frame, a
+// sub-range of a larger buffer, a datagram or a memory-mapped file alike. The viewed
+// bytes must outlive the span.
+class ByteSpan {
+public:
+    using value_type = std::uint8_t;
+    using size_type = std::size_t;
+    using const_pointer = const value_type*;
+    using const_iterator = const_pointer;
+
+    constexpr ByteSpan() noexcept : data_(nullptr), size_(0) {}
+    constexpr ByteSpan(const_pointer data, size_type size) noexcept : data_(data), size_(size) {}
+    ByteSpan(const void* data, size_type size) noexcept
+            : data_(static_cast<const_pointer>(data)), size_(size) {}
+
+    template<std::size_t InlineN>
+    ByteSpan(const BasicByteVector<InlineN>& bytes) noexcept : data_(bytes.data()), size_(bytes.size()) {}
+
+    ByteSpan(const SharedBuffer& bytes) noexcept : data_(bytes.data()), size_(bytes.size()) {}
+
+    constexpr ByteSpan(std::span<const value_type> bytes) noexcept : data_(bytes.data()), size_(bytes.size()) {}
+
+    constexpr const_pointer data() const noexcept { return data_; }
+    constexpr size_type size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+    constexpr const_iterator begin() const noexcept { return data_; }
+    constexpr const_iterator end() const noexcept { return data_ + size_; }
+
+    constexpr value_type operator[](size_type index) const { return data_[index]; }
+
+    // Bytes [offset, offset + count); throws if the range is out of bounds
+    ByteSpan subspan(size_type offset, size_type count) const {
+        if (offset > size_ || count > size_ - offset) {
+            throw std::runtime_error("ByteSpan::subspan: range out of bounds");
+        }
+        return {data_ + offset, count};
+    }
+
+    ByteSpan subspan(size_type offset) const {
+        if (offset > size_) {
+            throw std::runtime_error("ByteSpan::subspan: offset out of bounds");
+        }
+        return {data_ + offset, size_ - offset};
+    }
+
+private:
+    const_pointer data_;
+    size_type size_;
+};
+
+// Loads a little-endian (wire order) value straight from unaligned memory
+template<typename T>
+inline T load_little_endian(const std::uint8_t* source) {
+    static_assert(std::is_trivially_copyable_v<T>, "not a TriviallyCopyable type");
+    T value;
+    std::memcpy(&value, source, sizeof(T));
+    if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+        auto* bytes = reinterpret_cast<std::uint8_t*>(&value);
+        for (std::size_t i = 0; i < sizeof(T) / 2; ++i) {
+            std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+        }
+    }
+    return value;
+}
+
+// Forward-only decoding cursor over a ByteSpan. Every read checks the remaining length
+// and throws std::runtime_error when the input is too short, leaving the position unchanged.
+class ByteReader {
+public:
+    using size_type = std::size_t;
+
+    explicit ByteReader(ByteSpan data, size_type offset = 0) : data_(data), offset_(offset) {
+        if (offset > data.size()) {
+            throw std::runtime_error("ByteReader: offset past the end of the data");
+        }
+    }
+
+    size_type position() const { return offset_; }
+    size_type remaining() const { return data_.size() - offset_; }
+    bool atEnd() const { return offset_ == data_.size(); }
+    ByteSpan data() const { return data_; }
+
+    void require(size_type n) const {
+        if (n > remaining()) {
+            throw std::runtime_error("Not enough data to read");
+        }
+    }
+
+    void skip(size_type n) {
+        require(n);
+        offset_ += n;
+    }
+
+    // Decodes a trivially copyable value in wire byte order
+    template<typename T>
+    T read() {
+        require(sizeof(T));
+        T value = load_little_endian<T>(data_.data() + offset_);
+        offset_ += sizeof(T);
+        return value;
+    }
+
+    // Decodes count values written by ByteWriter::writeArray() into out
+    template<typename T>
+    void readArray(T* out, size_type count) {
+        static_assert(std::is_trivially_copyable_v<T>, "not a TriviallyCopyable type");
+        if (count > remaining() / sizeof(T)) {
+            throw std::runtime_error("Not enough data to read");
+        }
+        if (count > 0) {
+            std::memcpy(out, data_.data() + offset_, count * sizeof(T));
+        }
+        if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+            detail::reverse_element_bytes<T>(reinterpret_cast<std::uint8_t*>(out), count);
+        }
+        offset_ += count * sizeof(T);
+    }
+
+    // The next n bytes as a view into the underlying data
+    ByteSpan readBytes(size_type n) {
+        require(n);
+        ByteSpan bytes(data_.data() + offset_, n);
+        offset_ += n;
+        return bytes;
+    }
+
+    // A uint32 length prefix followed by that many bytes, as a view
+    ByteSpan readLengthPrefixed() {
+        require(sizeof(std::uint32_t));
+        auto length = load_little_endian<std::uint32_t>(data_.data() + offset_);
+        if (length > remaining() - sizeof(std::uint32_t)) {
+            throw std::runtime_error("Not enough data to read length-prefixed bytes");
+        }
+        offset_ += sizeof(std::uint32_t);
+        return readBytes(length);
+    }
+
+private:
+    ByteSpan data_;
+    size_type offset_;
+};
+
+
+}
@@ -3,17 +3,26 @@
 #include <cstdint>
 #include <cstring>
 #include <algorithm>
+#include <array>
 #include <stdexcept>
 #include <vector>
 #include <cassert>
-#include <mutex>
+#include <span>
+
+#include "MemoryPool.h"
 
 
 namespace FastVector
 {
 
 
-class ByteVector {
+// Byte container with InlineN bytes of inline storage. Contents that fit inline live
+// inside the object; anything larger is kept in a MemoryPool block. Pick the inline
+// capacity per call site: a vector that is moved around or held in a queue should stay
+// small (a move has to memcpy the inline bytes), a short-lived scratch buffer can be
+// larger to avoid touching the pool at all.
+template<std::size_t InlineN>
+class BasicByteVector {
 public:
     using value_type = std::uint8_t;
     using size_type = std::size_t;
@@ -24,114 +33,134 @@ public:
     using iterator = pointer;
     using const_iterator = const_pointer;
 
-    static constexpr size_type CHUNK_SIZE = 32768;  // Size of each memory chunk
-    static constexpr size_type SMALL_OBJECT_THRESHOLD = 4096;  // Threshold for small object optimization
+    static constexpr size_type SMALL_OBJECT_THRESHOLD = InlineN;  // Threshold for small object optimization
 
-    ByteVector() : size_(0), capacity_(SMALL_OBJECT_THRESHOLD), data_(small_buffer_) {}
+    BasicByteVector() : size_(0), capacity_(SMALL_OBJECT_THRESHOLD), data_(inline_data()) {}
 
-    explicit ByteVector(size_type count, value_type value = value_type())
-            : size_(count), capacity_(count > SMALL_OBJECT_THRESHOLD ? count : SMALL_OBJECT_THRESHOLD) {
+    explicit BasicByteVector(size_type count, value_type value = value_type())
+            : size_(count), capacity_(SMALL_OBJECT_THRESHOLD), data_(inline_data()) {
         if (count > SMALL_OBJECT_THRESHOLD) {
-            data_ = allocate(count);
-        } else {
-            data_ = small_buffer_;
+            acquire(count);
         }
         std::fill_n(data_, count, value);
     }
 
     template<typename InputIt>
-    ByteVector(InputIt first, InputIt last) {
+    BasicByteVector(InputIt first, InputIt last)
+            : size_(0), capacity_(SMALL_OBJECT_THRESHOLD), data_(inline_data()) {
         size_type count = std::distance(first, last);
         size_ = count;
-        capacity_ = count > SMALL_OBJECT_THRESHOLD ? count : SMALL_OBJECT_THRESHOLD;
         if (count > SMALL_OBJECT_THRESHOLD) {
-            data_ = allocate(count);
-        } else {
-            data_ = small_buffer_;
+            acquire(count);
         }
         std::copy(first, last, data_);
     }
 
-    ByteVector(const ByteVector& other)
-            : size_(other.size_), capacity_(other.capacity_) {
-        if (capacity_ > SMALL_OBJECT_THRESHOLD) {
-            data_ = allocate(capacity_);
-        } else {
-            data_ = small_buffer_;
-            capacity_ = SMALL_OBJECT_THRESHOLD;
+    BasicByteVector(const BasicByteVector& other)
+            : size_(other.size_), capacity_(SMALL_OBJECT_THRESHOLD), data_(inline_data()) {
+        if (size_ > SMALL_OBJECT_THRESHOLD) {
+            acquire(size_);
         }
-        std::memcpy(data_, other.data_, size_);
+        copy_bytes(data_, other.data_, size_);
     }
 
+    // Copies from a vector with a different inline capacity
+    template<std::size_t OtherN>
+    explicit BasicByteVector(const BasicByteVector<OtherN>& other)
+            : size_(other.size_), capacity_(SMALL_OBJECT_THRESHOLD), data_(inline_data()) {
+        if (size_ > SMALL_OBJECT_THRESHOLD) {
+            acquire(size_);
+        }
+        copy_bytes(data_, other.data_, size_);
+    }
 
+    // Moves from a vector with a different inline capacity. Heap storage is taken over
+    // as is whenever the contents do not fit inline, so no bytes are copied; contents
+    // that do fit are copied and the source's heap block, if any, is released.
+    template<std::size_t OtherN>
+    explicit BasicByteVector(BasicByteVector<OtherN>&& other) noexcept
+            : size_(other.size_), capacity_(SMALL_OBJECT_THRESHOLD), data_(inline_data()) {
+        if (size_ <= SMALL_OBJECT_THRESHOLD) {
+            copy_inline(other);
+            if (!other.is_inline()) {
+                deallocate(other.data_, other.capacity_);
+            }
+            other.reset_to_inline();
+        } else if (!other.is_inline()) {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inline_data();
+            other.size_ = 0;
+            other.capacity_ = OtherN;
+        } else {
+            acquire(size_);
+            copy_bytes(data_, other.data_, size_);
+            other.size_ = 0;
+        }
+    }
 
-    ~ByteVector() {
-        if (data_ != small_buffer_) {
+    ~BasicByteVector() {
+        if (!is_inline()) {
             deallocate(data_, capacity_);
         }
     }
 
-    ByteVector& operator=(const ByteVector& other) {
+    BasicByteVector& operator=(const BasicByteVector& other) {
         if (this != &other) {
-            if (other.capacity_ > capacity_) {
-                if (data_ != small_buffer_) {
+            if (other.size_ > capacity_) {
+                if (!is_inline()) {
                     deallocate(data_, capacity_);
                 }
-                data_ = allocate(other.capacity_);
-                capacity_ = other.capacity_;
-            } else if (other.capacity_ <= SMALL_OBJECT_THRESHOLD && data_ != small_buffer_) {
+                acquire(other.size_);
+            } else if (other.size_ <= SMALL_OBJECT_THRESHOLD && !is_inline()) {
                 deallocate(data_, capacity_);
-                data_ = small_buffer_;
+                data_ = inline_data();
                 capacity_ = SMALL_OBJECT_THRESHOLD;
             }
             size_ = other.size_;
-            std::memcpy(data_, other.data_, size_);
+            copy_bytes(data_, other.data_, size_);
         }
         return *this;
     }
 
-    ByteVector& operator=(ByteVector&& other) noexcept {
+    BasicByteVector& operator=(BasicByteVector&& other) noexcept {
         if (this != &other) {
             // Deallocate current resources if necessary
-            if (data_ != small_buffer_) {
+            if (!is_inline()) {
                 deallocate(data_, capacity_);
             }
 
             size_ = other.size_;
             capacity_ = other.capacity_;
 
-            if (other.data_ == other.small_buffer_) {
+            if (other.is_inline()) {
                 // Other uses small buffer optimization
-                data_ = small_buffer_;
-                std::memcpy(data_, other.data_, size_);
+                data_ = inline_data();
+                copy_inline(other);
             } else {
                 // Other uses dynamically allocated memory
                 data_ = other.data_;
             }
 
             // Reset other to empty state
-            other.data_ = other.small_buffer_;
-            other.size_ = 0;
-            other.capacity_ = SMALL_OBJECT_THRESHOLD;
+            other.reset_to_inline();
         }
         return *this;
     }
 
-    ByteVector(ByteVector&& other) noexcept
+    BasicByteVector(BasicByteVector&& other) noexcept
             : size_(other.size_), capacity_(other.capacity_) {
-        if (other.data_ == other.small_buffer_) {
+        if (other.is_inline()) {
             // Other uses small buffer optimization
-            data_ = small_buffer_;
-            std::memcpy(data_, other.data_, size_);
+            data_ = inline_data();
+            copy_inline(other);
         } else {
             // Other uses dynamically allocated memory
             data_ = other.data_;
         }
 
         // Reset other to empty state
-        other.data_ = other.small_buffer_;
-        other.size_ = 0;
-        other.capacity_ = SMALL_OBJECT_THRESHOLD;
+        other.reset_to_inline();
     }
     reference operator[](size_type index) { return data_[index]; }
     const_reference operator[](size_type index) const { return data_[index]; }
@@ -159,13 +188,13 @@ public:
 
     void reserve(size_type new_capacity) {
         if (new_capacity > capacity_) {
-            pointer new_data = allocate(new_capacity);
-            std::memcpy(new_data, data_, size_);
-            if (data_ != small_buffer_) {
+            MemoryPool::Block block = MemoryPool::getInstance().allocate(new_capacity);
+            copy_bytes(static_cast<pointer>(block.data), data_, size_);
+            if (!is_inline()) {
                 deallocate(data_, capacity_);
             }
-            data_ = new_data;
-            capacity_ = new_capacity;
+            data_ = static_cast<pointer>(block.data);
+            capacity_ = block.size;
         }
     }
 
@@ -173,7 +202,7 @@ public:
 
     void push_back(const value_type& value) {
         if (size_ == capacity_) {
-            reserve(capacity_ * 2);
+            grow(size_ + 1);
         }
         data_[size_++] = value;
     }
@@ -185,7 +214,7 @@ public:
     iterator insert(const_iterator pos, const value_type& value) {
         size_type index = pos - begin();
         if (size_ == capacity_) {
-            reserve(capacity_ * 2);
+            grow(size_ + 1);
         }
         std::memmove(data_ + index + 1, data_ + index, (size_ - index) * sizeof(value_type));
         data_[index] = value;
@@ -198,7 +227,10 @@ public:
         size_type index = pos - begin();
         size_type count = std::distance(first, last);
         if (size_ + count > capacity_) {
-            reserve(std::max(capacity_ * 2, size_ + count));
+            grow(size_ + count);
+        }
+        if (count == 0) {
+            return begin() + index;
         }
         std::memmove(data_ + index + count, data_ + index, (size_ - index) * sizeof(value_type));
         std::copy(first, last, begin() + index);
@@ -228,82 +260,100 @@ public:
         size_ = new_size;
     }
 
+    // Like resize(), but leaves any new bytes uninitialized. Meant for buffers that are
+    // about to be overwritten in full, e.g. by a socket read.
+    void resize_uninitialized(size_type new_size) {
+        if (new_size > capacity_) {
+            reserve(new_size);
+        }
+        size_ = new_size;
+    }
+
+    // Makes room for n more bytes and returns the uninitialized range behind the current
+    // contents. The bytes only become part of the vector once commit() is called with
+    // the number actually written; the span is invalidated by any other growth.
+    std::span<value_type> append_uninitialized(size_type n) {
+        if (size_ + n > capacity_) {
+            grow(size_ + n);
+        }
+        return {data_ + size_, n};
+    }
+
+    void commit(size_type n) {
+        assert(size_ + n <= capacity_);
+        size_ += n;
+    }
+
 private:
+    template<std::size_t> friend class BasicByteVector;
+
     size_type size_;
     size_type capacity_;
     pointer data_;
-    value_type small_buffer_[SMALL_OBJECT_THRESHOLD];
+    std::array<value_type, InlineN> small_buffer_;
 
-    static pointer allocate(size_type n) {
-        return static_cast<pointer>(MemoryPool::getInstance().allocate(n));
-    }
-
-    static void deallocate(pointer p, size_type n) {
-        MemoryPool::getInstance().deallocate(p, n);
+    // A heap-only vector has no inline storage and uses nullptr as its empty data pointer
+    pointer inline_data() {
+        if constexpr (InlineN == 0) {
+            return nullptr;
+        } else {
+            return small_buffer_.data();
+        }
     }
 
-    class MemoryPool {
-    public:
-        static MemoryPool& getInstance() {
-            static MemoryPool instance;
-            return instance;
+    bool is_inline() const {
+        if constexpr (InlineN == 0) {
+            return data_ == nullptr;
+        } else {
+            return data_ == small_buffer_.data();
         }
+    }
 
-        void* allocate(size_type n) {
-            std::lock_guard<std::mutex> lock(chunk_mutex);
-            size_type chunk_count = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
-            if (free_chunks_.size() < chunk_count) {
-                allocate_more_chunks(chunk_count - free_chunks_.size());
-            }
-            void* result = free_chunks_.back();
-            free_chunks_.pop_back();
-            for (size_type i = 1; i < chunk_count; ++i) {
-                used_chunks_.push_back(free_chunks_.back());
-                free_chunks_.pop_back();
-            }
-            return result;
-        }
+    void reset_to_inline() {
+        data_ = inline_data();
+        size_ = 0;
+        capacity_ = SMALL_OBJECT_THRESHOLD;
+    }
 
-        void deallocate(void* p, size_type n) {
-            if (p == nullptr) return;  // Add this null check
-            std::lock_guard<std::mutex> lock(chunk_mutex);
-            size_type chunk_count = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
-            free_chunks_.push_back(p);
-            for (size_type i = 1; i < chunk_count; ++i) {
-                if (!used_chunks_.empty()) {  // Add this check to prevent undefined behavior
-                    free_chunks_.push_back(used_chunks_.back());
-                    used_chunks_.pop_back();
-                }
-            }
-        }
+    void grow(size_type min_capacity) {
+        reserve(std::max(capacity_ * 2, min_capacity));
+    }
 
-    private:
-        MemoryPool() {
-            std::lock_guard<std::mutex> lock(chunk_mutex);
-            allocate_more_chunks(16);  // Start with 16 chunks
+    // Copies the contents of a vector whose size_ fits the inline buffer; a heap-only
+    // vector is empty whenever it is inline, so there is nothing to copy
+    template<std::size_t OtherN>
+    void copy_inline(const BasicByteVector<OtherN>& other) {
+        if constexpr (InlineN > 0) {
+            copy_bytes(data_, other.data_, size_);
         }
+    }
 
-        ~MemoryPool() {
-            for (void* chunk : free_chunks_) {
-                ::operator delete(chunk);
-            }
-            for (void* chunk : used_chunks_) {
-                ::operator delete(chunk);
-            }
+    static void copy_bytes(pointer dest, const_pointer src, size_type n) {
+        if (n > 0) {
+            std::memcpy(dest, src, n);
         }
+    }
 
-        void allocate_more_chunks(size_type count) {
+    // Points data_ at a fresh pool block of at least n bytes; the pool rounds the
+    // request up to its size class, and that rounded size becomes the capacity
+    void acquire(size_type n) {
+        MemoryPool::Block block = MemoryPool::getInstance().allocate(n);
+        data_ = static_cast<pointer>(block.data);
+        capacity_ = block.size;
+    }
 
-            for (size_type i = 0; i < count; ++i) {
-                void* new_chunk = ::operator new(CHUNK_SIZE);
-                free_chunks_.push_back(new_chunk);
-            }
-        }
-        std::mutex chunk_mutex;
-        std::vector<void*> free_chunks_;
-        std::vector<void*> used_chunks_;
-    };
+    static void deallocate(pointer p, size_type n) {
+        MemoryPool::getInstance().deallocate(p, n);
+    }
 };
 
+template<std::size_t InlineN>
+using SmallByteVector = BasicByteVector<InlineN>;
+
+using HeapByteVector = BasicByteVector<0>;      // Cheap to move; for queued and shared buffers
+using TinyByteVector = BasicByteVector<64>;     // Scalars, headers and other fixed-size fields
+using ShortByteVector = BasicByteVector<256>;   // Short strings and small messages
+using ByteVector = BasicByteVector<4096>;       // Whole frames and general-purpose buffers
+
 
 }
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+
+namespace FastVector
+{
+
+// Stores a value in little-endian (wire) order into unaligned memory
+template<typename T>
+inline void store_little_endian(std::uint8_t* destination, T value) {
+    static_assert(std::is_trivially_copyable_v<T>, "not a TriviallyCopyable type");
+    if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+        auto* bytes = reinterpret_cast<std::uint8_t*>(&value);
+        for (std::size_t i = 0; i < sizeof(T) / 2; ++i) {
+            std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+        }
+    }
+    std::memcpy(destination, &value, sizeof(T));
+}
+
+namespace detail
+{
+    // Reverses the bytes of each of count consecutive T-sized elements in place; the
+    // element size is a constant, so compilers turn this into vector shuffles
+    template<typename T>
+    inline void reverse_element_bytes(std::uint8_t* bytes, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            std::uint8_t* element = bytes + i * sizeof(T);
+            for (std::size_t k = 0; k < sizeof(T) / 2; ++k) {
+                std::swap(element[k], element[sizeof(T) - 1 - k]);
+            }
+        }
+    }
+}
+
+// Forward-only encoding cursor over a caller-provided, pre-sized buffer. The counterpart
+// of ByteReader: size the buffer once (e.g. from BinaryData::serializedSize()), then write
+// every field straight into it. Writing past the end throws std::runtime_error.
+class ByteWriter {
+public:
+    using size_type = std::size_t;
+
+    ByteWriter(std::uint8_t* data, size_type capacity) : data_(data), capacity_(capacity), offset_(0) {}
+
+    size_type position() const { return offset_; }
+    size_type capacity() const { return capacity_; }
+    size_type remaining() const { return capacity_ - offset_; }
+    std::uint8_t* data() const { return data_; }
+
+    void require(size_type n) const {
+        if (n > remaining()) {
+            throw std::runtime_error("Not enough space to write");
+        }
+    }
+
+    // Encodes a trivially copyable value in wire byte order
+    template<typename T>
+    void write(T value) {
+        require(sizeof(T));
+        store_little_endian<T>(data_ + offset_, value);
+        offset_ += sizeof(T);
+    }
+
+    // Encodes count values in wire byte order: one memcpy, plus an in-place byte swap
+    // on big-endian hosts
+    template<typename T>
+    void writeArray(const T* values, size_type count) {
+        static_assert(std::is_trivially_copyable_v<T>, "not a TriviallyCopyable type");
+        if (count > remaining() / sizeof(T)) {
+            throw std::runtime_error("Not enough space to write");
+        }
+        std::uint8_t* start = skip(count * sizeof(T));
+        if (count > 0) {
+            std::memcpy(start, values, count * sizeof(T));
+        }
+        if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+            detail::reverse_element_bytes<T>(start, count);
+        }
+    }
+
+    void writeBytes(const void* source, size_type n) {
+        require(n);
+        if (n > 0) {
+            std::memcpy(data_ + offset_, source, n);
+        }
+        offset_ += n;
+    }
+
+    // Reserves n bytes for the caller to fill in place
+    std::uint8_t* skip(size_type n) {
+        require(n);
+        std::uint8_t* start = data_ + offset_;
+        offset_ += n;
+        return start;
+    }
+
+private:
+    std::uint8_t* data_;
+    size_type capacity_;
+    size_type offset_;
+};
+
+
+}
@@ -2,53 +2,577 @@
 
 #include <vector>
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <type_traits>
 #include <unordered_map>
-#include <functional>
-#include <typeindex>
 #include <utility>
 #include <variant>
 #include <fstream>
+#include <functional>
 #include "BinaryData.h"
+#include "MessagePool.h"
+#include "Utf8.h"
 
 using json = nlohmann::json;
 namespace JSONPayload
 {
+
+// Slot of a named field in a message definition. Resolve it once, from
+// MessageFactory::field() or DynamicPayload::field(), and use it for every get and set
+// instead of the name.
+struct FieldHandle {
+    std::uint16_t slot = 0;
+};
+
+// Field types of the definition format:
+//   bool, int8, int16, int32 (or int), int64, uint8, uint16, uint32, uint64, float, double
+//   string    uint32 length + UTF-8 bytes
+//   bytes     uint32 length + raw bytes
+//   <Name>    another message, from the same file or one loaded before, written inline
+// Any type but bytes can be a fixed-length array, "float[3]", or a repeated field with a
+// uint32 element count in front, "Position[]". Numbers are little-endian, bools one byte;
+// the encoding is the one MessageSchema uses for the same C++ types, std::array and
+// std::vector.
+enum class FieldType : std::uint8_t {
+    Bool, Int8, Int16, Int32, Int64, UInt8, UInt16, UInt32, UInt64, Float, Double,
+    String, Bytes, Message
+};
+
+namespace detail
+{
+    // Wire size of a number or bool, 0 for the variable-size types
+    constexpr std::size_t scalar_size(FieldType type) {
+        switch (type) {
+            case FieldType::Bool: case FieldType::Int8: case FieldType::UInt8: return 1;
+            case FieldType::Int16: case FieldType::UInt16: return 2;
+            case FieldType::Int32: case FieldType::UInt32: case FieldType::Float: return 4;
+            case FieldType::Int64: case FieldType::UInt64: case FieldType::Double: return 8;
+            default: return 0;
+        }
+    }
+
+    template<typename T>
+    constexpr FieldType field_type_of() {
+        static_assert(std::is_arithmetic_v<T>, "Only numbers and bool have a fixed-width field type");
+        if constexpr (std::is_same_v<T, bool>) {
+            return FieldType::Bool;
+        } else if constexpr (std::is_same_v<T, float>) {
+            return FieldType::Float;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return FieldType::Double;
+        } else if constexpr (std::is_signed_v<T>) {
+            return sizeof(T) == 1 ? FieldType::Int8 : sizeof(T) == 2 ? FieldType::Int16
+                 : sizeof(T) == 4 ? FieldType::Int32 : FieldType::Int64;
+        } else {
+            return sizeof(T) == 1 ? FieldType::UInt8 : sizeof(T) == 2 ? FieldType::UInt16
+                 : sizeof(T) == 4 ? FieldType::UInt32 : FieldType::UInt64;
+        }
+    }
+
+    // Calls func(std::type_identity<T>{}) with the C++ type of a number or bool field
+    template<typename Func>
+    decltype(auto) visit_scalar(FieldType type, Func&& func) {
+        switch (type) {
+            case FieldType::Bool: return func(std::type_identity<bool>{});
+            case FieldType::Int8: return func(std::type_identity<std::int8_t>{});
+            case FieldType::Int16: return func(std::type_identity<std::int16_t>{});
+            case FieldType::Int32: return func(std::type_identity<std::int32_t>{});
+            case FieldType::Int64: return func(std::type_identity<std::int64_t>{});
+            case FieldType::UInt8: return func(std::type_identity<std::uint8_t>{});
+            case FieldType::UInt16: return func(std::type_identity<std::uint16_t>{});
+            case FieldType::UInt32: return func(std::type_identity<std::uint32_t>{});
+            case FieldType::UInt64: return func(std::type_identity<std::uint64_t>{});
+            case FieldType::Float: return func(std::type_identity<float>{});
+            case FieldType::Double: return func(std::type_identity<double>{});
+            default: break;
+        }
+        throw std::runtime_error("DynamicPayload field has the wrong type");
+    }
+
+    template<typename T>
+    T load_scalar(const std::uint8_t* source) {
+        if constexpr (std::is_same_v<T, bool>) {
+            return *source != 0;
+        } else {
+            return FastVector::load_little_endian<T>(source);
+        }
+    }
+
+    template<typename T>
+    void store_scalar(std::uint8_t* destination, T value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            *destination = value ? 1 : 0;
+        } else {
+            FastVector::store_little_endian(destination, value);
+        }
+    }
+}
+
+// A message definition compiled into a flat list of instructions in wire order. Adjacent
+// fixed-width fields, numbers, bools and fixed-length arrays of them, form one Block: the
+// payload keeps them in a little-endian image laid out as on the wire, so a block is
+// written and read with a single memcpy. Every other field is one instruction of its
+// own. Both directions run as one switch over the list.
+struct FieldProgram {
+    enum class Op : std::uint8_t {
+        Block,     // size bytes of the block image, starting at offset
+        String,    // uint32 length + UTF-8 bytes
+        Bytes,     // uint32 length + raw bytes
+        Array,     // Repeated number: uint32 count + elements
+        Strings,   // String array: uint32 count if repeated, then each string
+        Messages   // Nested messages: uint32 count if repeated, then each message
+    };
+
+    struct Instruction {
+        Op op;
+        std::uint16_t slot;
+        std::uint32_t offset;
+        std::uint32_t size;
+    };
+
+    struct Field {
+        std::string name;
+        FieldType type = FieldType::Int32;
+        std::uint32_t count = 1;   // Length of a fixed-length array, 1 for a single value
+        bool repeated = false;     // The element count goes on the wire
+        bool fixed = false;        // Lives in the block image
+        std::uint32_t offset = 0;  // Offset in the block image, or index of the variable slot
+        std::shared_ptr<const FieldProgram> message;  // Definition of nested messages
+    };
+
+    std::vector<Instruction> code;
+    std::vector<Field> fields;  // By slot, in wire order
+    std::unordered_map<std::string, FieldHandle> names;
+    std::size_t blockSize = 0;  // Bytes of all fixed-width fields together
+    std::size_t variableCount = 0;
+    std::size_t minWireSize = 0;
+    std::optional<std::size_t> wireSize;  // Set when every payload has the same size
+
+    FieldHandle handle(const std::string& name) const {
+        auto it = names.find(name);
+        if (it == names.end()) {
+            throw std::runtime_error("Unknown field: " + name);
+        }
+        return it->second;
+    }
+};
+
 class DynamicPayload : public NetworkMessages::BinaryData {
 public:
-    using FieldValue = std::variant<std::string, int, float>;
     using byte = uint8_t;
+    using Bytes = std::vector<byte>;
 
     DynamicPayload() = default;
-    DynamicPayload(
-            std::function<ByteVector(const std::vector<FieldValue>&)> serializeFunc,
-            std::function<void(const ByteVector&, std::vector<FieldValue>&)> deserializeFunc,
-            size_t expectedFieldCount
-    ) : compiledSerialize(std::move(serializeFunc)), compiledDeserialize(std::move(deserializeFunc)) {
-        fields.reserve(expectedFieldCount);
+    // Every field starts out set: numbers to 0, strings and repeated fields empty, and
+    // fixed-length arrays at their full length
+    explicit DynamicPayload(std::shared_ptr<const FieldProgram> program)
+            : block(program->blockSize, 0), program(std::move(program)) {
+        values.reserve(this->program->variableCount);
+        for (const auto& field : this->program->fields) {
+            std::size_t count = field.repeated ? 0 : field.count;
+            if (field.fixed) {
+                continue;
+            } else if (field.type == FieldType::Message) {
+                values.emplace_back(std::vector<DynamicPayload>(count, DynamicPayload(field.message)));
+            } else if (field.type == FieldType::String && (field.repeated || field.count != 1)) {
+                values.emplace_back(std::vector<std::string>(count));
+            } else if (field.type == FieldType::String) {
+                values.emplace_back(std::string());
+            } else {
+                values.emplace_back(Bytes());
+            }
+        }
     }
 
     [[nodiscard]] ByteVector serialize() const override {
-        return compiledSerialize(fields);
+        return serialize_single_pass();
+    }
+
+    [[nodiscard]] size_t serializedSize() const override {
+        const FieldProgram& code = checkedProgram();
+        if (code.wireSize) {
+            return *code.wireSize;
+        }
+        size_t size = code.blockSize;
+        for (const auto& instruction : code.code) {
+            const auto& field = code.fields[instruction.slot];
+            size_t prefix = field.repeated ? sizeof(uint32_t) : 0;
+            switch (instruction.op) {
+                case FieldProgram::Op::Block:
+                    break;
+                case FieldProgram::Op::String:
+                    size += sizeof(uint32_t) + std::get<std::string>(values[field.offset]).size();
+                    break;
+                case FieldProgram::Op::Bytes:
+                case FieldProgram::Op::Array:
+                    size += sizeof(uint32_t) + std::get<Bytes>(values[field.offset]).size();
+                    break;
+                case FieldProgram::Op::Strings:
+                    size += prefix;
+                    for (const auto& text : std::get<std::vector<std::string>>(values[field.offset])) {
+                        size += sizeof(uint32_t) + text.size();
+                    }
+                    break;
+                case FieldProgram::Op::Messages:
+                    size += prefix;
+                    for (const auto& message : std::get<std::vector<DynamicPayload>>(values[field.offset])) {
+                        size += message.serializedSize();
+                    }
+                    break;
+            }
+        }
+        return size;
+    }
+
+    void serializeInto(FastVector::ByteWriter& writer) const override {
+        const FieldProgram& code = checkedProgram();
+        for (const auto& instruction : code.code) {
+            const auto& field = code.fields[instruction.slot];
+            switch (instruction.op) {
+                case FieldProgram::Op::Block:
+                    writer.writeBytes(block.data() + instruction.offset, instruction.size);
+                    break;
+                case FieldProgram::Op::String:
+                    writeString(writer, std::get<std::string>(values[field.offset]));
+                    break;
+                case FieldProgram::Op::Bytes:
+                case FieldProgram::Op::Array: {
+                    const auto& bytes = std::get<Bytes>(values[field.offset]);
+                    size_t element = instruction.op == FieldProgram::Op::Array ? detail::scalar_size(field.type) : 1;
+                    writer.write(static_cast<uint32_t>(bytes.size() / element));
+                    writer.writeBytes(bytes.data(), bytes.size());
+                    break;
+                }
+                case FieldProgram::Op::Strings: {
+                    const auto& texts = std::get<std::vector<std::string>>(values[field.offset]);
+                    writeCount(writer, field, texts.size());
+                    for (const auto& text : texts) {
+                        writeString(writer, text);
+                    }
+                    break;
+                }
+                case FieldProgram::Op::Messages: {
+                    const auto& messages = std::get<std::vector<DynamicPayload>>(values[field.offset]);
+                    writeCount(writer, field, messages.size());
+                    for (const auto& message : messages) {
+                        message.serializeInto(writer);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // Reads from the caller's offset so the payload can follow the message type header.
+    // Strings and nested messages decoded into a payload that already holds some reuse
+    // their storage.
+    void deserialize(FastVector::ByteSpan data, size_t& offset) override {
+        const FieldProgram& code = checkedProgram();
+        FastVector::ByteReader reader(data, offset);
+        for (const auto& instruction : code.code) {
+            const auto& field = code.fields[instruction.slot];
+            switch (instruction.op) {
+                case FieldProgram::Op::Block:
+                    std::memcpy(block.data() + instruction.offset, reader.readBytes(instruction.size).data(), instruction.size);
+                    break;
+                case FieldProgram::Op::String:
+                    readString(reader, std::get<std::string>(values[field.offset]));
+                    break;
+                case FieldProgram::Op::Bytes:
+                case FieldProgram::Op::Array: {
+                    size_t element = instruction.op == FieldProgram::Op::Array ? detail::scalar_size(field.type) : 1;
+                    auto bytes = reader.readBytes(readCount(reader, field, element) * element);
+                    std::get<Bytes>(values[field.offset]).assign(bytes.begin(), bytes.end());
+                    break;
+                }
+                case FieldProgram::Op::Strings: {
+                    auto& texts = std::get<std::vector<std::string>>(values[field.offset]);
+                    texts.resize(readCount(reader, field, sizeof(uint32_t)));
+                    for (auto& text : texts) {
+                        readString(reader, text);
+                    }
+                    break;
+                }
+                case FieldProgram::Op::Messages: {
+                    auto& messages = std::get<std::vector<DynamicPayload>>(values[field.offset]);
+                    size_t count = readCount(reader, field, std::max<size_t>(1, field.message->minWireSize));
+                    // Keep the elements already there; only a growing list constructs new ones
+                    if (messages.size() > count) {
+                        messages.erase(messages.begin() + static_cast<std::ptrdiff_t>(count), messages.end());
+                    }
+                    while (messages.size() < count) {
+                        messages.emplace_back(field.message);
+                    }
+                    size_t position = reader.position();
+                    for (auto& message : messages) {
+                        message.deserialize(data, position);
+                    }
+                    reader.skip(position - reader.position());
+                    break;
+                }
+            }
+        }
+        offset = reader.position();
+    }
+
+    FieldHandle field(const std::string& name) const {
+        return checkedProgram().handle(name);
+    }
+
+    FieldHandle field(std::size_t index) const {
+        if (index >= checkedProgram().fields.size()) {
+            throw std::runtime_error("DynamicPayload field index out of range");
+        }
+        return FieldHandle{static_cast<std::uint16_t>(index)};
+    }
+
+    // Numbers and bools come back by value, converted to T; strings and bytes by reference
+    template<typename T>
+    decltype(auto) get(FieldHandle handle) const {
+        const auto& field = fieldAt(handle);
+        if constexpr (std::is_arithmetic_v<T>) {
+            if (!field.fixed || field.count != 1) {
+                throw std::runtime_error("DynamicPayload field has the wrong type");
+            }
+            return detail::visit_scalar(field.type, [&](auto type) {
+                using Stored = typename decltype(type)::type;
+                return static_cast<T>(detail::load_scalar<Stored>(block.data() + field.offset));
+            });
+        } else {
+            return slotValue<T>(field);
+        }
+    }
+
+    // By name, with a hash lookup per call; prefer a FieldHandle on hot paths
+    template<typename T>
+    decltype(auto) get(const std::string& name) const {
+        return get<T>(field(name));
+    }
+
+    template<typename T>
+    decltype(auto) get(const int& key) const {
+        return get<T>(field(static_cast<std::size_t>(key)));
+    }
+
+    // Numbers are converted to the field's type; strings only go into string fields, and
+    // assigning one reuses the slot's storage
+    template<typename T>
+    void set(FieldHandle handle, T&& value) {
+        const auto& field = fieldAt(handle);
+        if constexpr (std::is_arithmetic_v<std::remove_cvref_t<T>>) {
+            if (!field.fixed || field.count != 1) {
+                throw std::runtime_error("DynamicPayload field has the wrong type");
+            }
+            detail::visit_scalar(field.type, [&](auto type) {
+                using Stored = typename decltype(type)::type;
+                detail::store_scalar(block.data() + field.offset, static_cast<Stored>(value));
+            });
+        } else {
+            slot<std::string>(handle) = std::forward<T>(value);
+        }
+    }
+
+    template<typename T>
+    void set(const std::string& name, T&& value) {
+        set(field(name), std::forward<T>(value));
+    }
+
+    void setBytes(FieldHandle handle, FastVector::ByteSpan bytes) {
+        slot<Bytes>(handle).assign(bytes.begin(), bytes.end());
     }
 
-    void deserialize(const ByteVector& data, size_t& offset) override {
-        compiledDeserialize(data, fields);
+    // Elements of a fixed-length or repeated number field; T must be its element type
+    template<typename T>
+    std::vector<T> getArray(FieldHandle handle) const {
+        const auto& field = arrayField<T>(handle);
+        const byte* source = field.fixed ? block.data() + field.offset : std::get<Bytes>(values[field.offset]).data();
+        std::size_t count = field.fixed ? field.count : std::get<Bytes>(values[field.offset]).size() / sizeof(T);
+        std::vector<T> elements(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            elements[i] = detail::load_scalar<T>(source + i * sizeof(T));
+        }
+        return elements;
     }
 
+    // A fixed-length array takes exactly its length, a repeated field any count
     template<typename T>
-    void set(T&& value) {
-        fields.emplace_back(std::forward<T>(value));
+    void setArray(FieldHandle handle, const T* elements, std::size_t count) {
+        const auto& field = arrayField<T>(handle);
+        byte* destination;
+        if (field.fixed) {
+            if (count != field.count) {
+                throw std::runtime_error("Fixed-length array field has the wrong number of elements");
+            }
+            destination = block.data() + field.offset;
+        } else {
+            auto& bytes = std::get<Bytes>(values[field.offset]);
+            bytes.resize(count * sizeof(T));
+            destination = bytes.data();
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            detail::store_scalar(destination + i * sizeof(T), elements[i]);
+        }
     }
 
     template<typename T>
-    const T& get(const int& key) const {
-        return std::get<T>(fields.at(key));
+    void setArray(FieldHandle handle, const std::vector<T>& elements) {
+        setArray(handle, elements.data(), elements.size());
+    }
+
+    // Elements of a string array; a fixed-length one has to keep its length
+    std::vector<std::string>& strings(FieldHandle handle) {
+        return slot<std::vector<std::string>>(handle);
+    }
+
+    const std::vector<std::string>& strings(FieldHandle handle) const {
+        return slotValue<std::vector<std::string>>(fieldAt(handle));
+    }
+
+    // Nested messages of a message field: a single one is element 0
+    std::vector<DynamicPayload>& messages(FieldHandle handle) {
+        return slot<std::vector<DynamicPayload>>(handle);
+    }
+
+    const std::vector<DynamicPayload>& messages(FieldHandle handle) const {
+        return slotValue<std::vector<DynamicPayload>>(fieldAt(handle));
+    }
+
+    DynamicPayload& message(FieldHandle handle) {
+        return messages(handle).at(0);
+    }
+
+    const DynamicPayload& message(FieldHandle handle) const {
+        return messages(handle).at(0);
+    }
+
+    // Appends a message with default fields to a repeated message field
+    DynamicPayload& addMessage(FieldHandle handle) {
+        const auto& field = fieldAt(handle);
+        if (field.type != FieldType::Message || !field.repeated) {
+            throw std::runtime_error("DynamicPayload field is not a repeated message");
+        }
+        return std::get<std::vector<DynamicPayload>>(values[field.offset]).emplace_back(field.message);
+    }
+
+    // Back to the state of a new payload, keeping the capacity of strings and vectors
+    void reset() {
+        if (!program) {
+            return;
+        }
+        std::fill(block.begin(), block.end(), 0);
+        for (const auto& field : program->fields) {
+            if (field.fixed) {
+                continue;
+            }
+            std::visit([&](auto& value) {
+                using Value = std::remove_cvref_t<decltype(value)>;
+                if constexpr (std::is_same_v<Value, std::vector<std::string>>) {
+                    if (field.repeated) {
+                        value.clear();
+                    }
+                    for (auto& text : value) {
+                        text.clear();
+                    }
+                } else if constexpr (std::is_same_v<Value, std::vector<DynamicPayload>>) {
+                    if (field.repeated) {
+                        value.clear();
+                    }
+                    for (auto& message : value) {
+                        message.reset();
+                    }
+                } else {
+                    value.clear();
+                }
+            }, values[field.offset]);
+        }
+    }
+
+    const std::shared_ptr<const FieldProgram>& definition() const {
+        return program;
     }
 
 private:
-    std::vector<FieldValue> fields;
-    std::function<ByteVector(const std::vector<FieldValue>&)> compiledSerialize;
-    std::function<void(const ByteVector&, std::vector<FieldValue>&)> compiledDeserialize;
+    using Slot = std::variant<std::string, Bytes, std::vector<std::string>, std::vector<DynamicPayload>>;
+
+    const FieldProgram& checkedProgram() const {
+        if (!program) {
+            throw std::runtime_error("DynamicPayload has no message definition");
+        }
+        return *program;
+    }
+
+    const FieldProgram::Field& fieldAt(FieldHandle handle) const {
+        const auto& fields = checkedProgram().fields;
+        if (handle.slot >= fields.size()) {
+            throw std::runtime_error("DynamicPayload field index out of range");
+        }
+        return fields[handle.slot];
+    }
+
+    template<typename T>
+    const FieldProgram::Field& arrayField(FieldHandle handle) const {
+        const auto& field = fieldAt(handle);
+        if (field.type != detail::field_type_of<T>() || (!field.repeated && field.count == 1)) {
+            throw std::runtime_error("DynamicPayload field has the wrong type");
+        }
+        return field;
+    }
+
+    // Value of a field outside the block; a repeated number is also kept as Bytes, but
+    // only a bytes field hands them out
+    template<typename T>
+    const T& slotValue(const FieldProgram::Field& field) const {
+        const T* value = field.fixed ? nullptr : std::get_if<T>(&values[field.offset]);
+        if (!value || (std::is_same_v<T, Bytes> && field.type != FieldType::Bytes)) {
+            throw std::runtime_error("DynamicPayload field has the wrong type");
+        }
+        return *value;
+    }
+
+    template<typename T>
+    T& slot(FieldHandle handle) {
+        return const_cast<T&>(slotValue<T>(fieldAt(handle)));
+    }
+
+    static void writeString(FastVector::ByteWriter& writer, const std::string& text) {
+        writer.write(static_cast<uint32_t>(text.size()));
+        writer.writeBytes(text.data(), text.size());
+    }
+
+    static void writeCount(FastVector::ByteWriter& writer, const FieldProgram::Field& field, std::size_t count) {
+        if (field.repeated) {
+            writer.write(static_cast<uint32_t>(count));
+        } else if (count != field.count) {
+            throw std::runtime_error("Fixed-length array field has the wrong number of elements");
+        }
+    }
+
+    // Every element takes at least min_element_size bytes, which bounds a hostile count
+    static std::size_t readCount(FastVector::ByteReader& reader, const FieldProgram::Field& field, std::size_t min_element_size) {
+        if (!field.repeated && field.type != FieldType::Bytes) {
+            return field.count;
+        }
+        uint32_t count = reader.read<uint32_t>();
+        if (count > reader.remaining() / min_element_size) {
+            throw std::runtime_error("Element count exceeds the remaining data");
+        }
+        return count;
+    }
+
+    void readString(FastVector::ByteReader& reader, std::string& text) const {
+        auto bytes = reader.readBytes(reader.read<uint32_t>());
+        if (validate_utf8() && !FastVector::is_valid_utf8(bytes.data(), bytes.size())) {
+            throw std::runtime_error("Invalid UTF-8 sequence");
+        }
+        text.assign(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    Bytes block;  // Fixed-width fields, laid out as on the wire
+    std::vector<Slot> values;
+    std::shared_ptr<const FieldProgram> program;
 };
 
 class MessageFactory {
@@ -56,127 +580,286 @@ public:
     struct CompiledMessage {
         json definition;
         short type;
-        std::function<FastVector::ByteVector(const std::vector<DynamicPayload::FieldValue>&)> compiledSerialize;
-        std::function<void(const FastVector::ByteVector&, std::vector<DynamicPayload::FieldValue>&)> compiledDeserialize;
-        uint32_t fieldCount;
+        std::shared_ptr<const FieldProgram> program;
     };
 
+    // Messages may refer to each other in any order within a file, and to messages of
+    // files loaded before; a message may not contain itself
     static void loadDefinitions(const std::string& jsonPath) {
         std::ifstream file(jsonPath);
         json j;
         file >> j;
 
+        std::vector<std::string> compiling;
         for (auto&& [name, def] : j.items()) {
-            auto compiledMessage = compileMessage(def);
-            definitions.emplace(name, std::move(compiledMessage));
+            compileNamed(name, j, compiling);
         }
     }
 
+    // Handle of a field of a loaded definition, valid for every payload of that message
+    static FieldHandle field(const std::string& message, const std::string& name) {
+        return compiled(message).program->handle(name);
+    }
+
+    // Wire type of a loaded definition
+    static short typeOf(const std::string& message) {
+        return compiled(message).type;
+    }
+
+    // Payload size of a message made of fixed-width fields only, nullopt otherwise
+    static std::optional<std::size_t> wireSize(const std::string& message) {
+        return compiled(message).program->wireSize;
+    }
+
     static std::shared_ptr<NetworkMessages::BinaryMessage<DynamicPayload>> createMessage(const std::string& name) {
+        const auto& compiledMessage = compiled(name);
+        return std::make_shared<NetworkMessages::BinaryMessage<DynamicPayload>>(compiledMessage.type, DynamicPayload(compiledMessage.program));
+    }
+
+    static std::shared_ptr<NetworkMessages::BinaryMessage<DynamicPayload>> createMessage(short type) {
+        const auto& compiledMessage = compiled(type);
+        return std::make_shared<NetworkMessages::BinaryMessage<DynamicPayload>>(compiledMessage.type, DynamicPayload(compiledMessage.program));
+    }
+
+    // Message of the given type from the calling thread's pool; it comes back reset when
+    // the handle is dropped, so steady traffic reuses the same payloads
+    static NetworkMessages::MessagePool<NetworkMessages::BinaryMessage<DynamicPayload>>::Handle acquireMessage(short type) {
+        using Pool = NetworkMessages::MessagePool<NetworkMessages::BinaryMessage<DynamicPayload>>;
+        thread_local std::vector<std::unique_ptr<Pool>> pools;
+        const auto& program = compiled(type).program;
+        if (static_cast<size_t>(type) >= pools.size()) {
+            pools.resize(static_cast<size_t>(type) + 1);
+        }
+        if (!pools[type]) {
+            pools[type] = std::make_unique<Pool>([type, program]() {
+                return std::make_unique<NetworkMessages::BinaryMessage<DynamicPayload>>(type, DynamicPayload(program));
+            });
+        }
+        return pools[type]->acquire();
+    }
+
+    static NetworkMessages::MessagePool<NetworkMessages::BinaryMessage<DynamicPayload>>::Handle acquireMessage(const std::string& name) {
+        return acquireMessage(compiled(name).type);
+    }
+
+    // Definition with the given wire type, nullptr if none is loaded. A plain index into
+    // a table kept by type, so receive paths route without hashing a name.
+    static const CompiledMessage* find(short type) {
+        if (type < 0 || static_cast<size_t>(type) >= byType.size()) {
+            return nullptr;
+        }
+        return byType[type];
+    }
+
+    // Decodes the payload that follows the type header of a message of the given type.
+    // A payload already holding that definition is decoded in place, reusing its storage.
+    static void decode(short type, FastVector::ByteSpan payload, DynamicPayload& out) {
+        const auto& program = compiled(type).program;
+        if (out.definition() != program) {
+            out = DynamicPayload(program);
+        }
+        size_t offset = 0;
+        out.deserialize(payload, offset);
+    }
+
+    static DynamicPayload decode(short type, FastVector::ByteSpan payload) {
+        DynamicPayload out(compiled(type).program);
+        decode(type, payload, out);
+        return out;
+    }
+
+private:
+    static const CompiledMessage& compiled(const std::string& name) {
         auto it = definitions.find(name);
         if (it == definitions.end()) {
             throw std::runtime_error("Message definition not found: " + name);
         }
+        return it->second;
+    }
 
-        const auto& compiledMessage = it->second;
+    static const CompiledMessage& compiled(short type) {
+        const CompiledMessage* compiledMessage = find(type);
+        if (!compiledMessage) {
+            throw std::runtime_error("Message definition not found for type " + std::to_string(type));
+        }
+        return *compiledMessage;
+    }
 
-        auto payload = DynamicPayload(compiledMessage.compiledSerialize, compiledMessage.compiledDeserialize, compiledMessage.fieldCount);
-        return std::make_shared<NetworkMessages::BinaryMessage<DynamicPayload>>(compiledMessage.type, payload);
+    // Compiles a message of the file being loaded, after the messages it contains;
+    // compiling holds the chain of messages in progress to catch cycles
+    static const CompiledMessage& compileNamed(const std::string& name, const json& file, std::vector<std::string>& compiling) {
+        auto it = definitions.find(name);
+        if (it != definitions.end()) {
+            return it->second;
+        }
+        if (!file.contains(name)) {
+            throw std::runtime_error("Message definition not found: " + name);
+        }
+        if (std::find(compiling.begin(), compiling.end(), name) != compiling.end()) {
+            throw std::runtime_error("Message definition contains itself: " + name);
+        }
+        short type = file.at(name).at("type").get<short>();
+        if (type < 0) {
+            throw std::runtime_error("Message type out of range: " + name);
+        }
+        if (find(type)) {
+            throw std::runtime_error("Message type " + std::to_string(type) + " of " + name + " is already in use");
+        }
+        compiling.push_back(name);
+        auto compiledMessage = compileMessage(file.at(name), file, compiling);
+        compiling.pop_back();
+        // Map nodes never move, so the table can point into definitions
+        const auto& entry = definitions.emplace(name, std::move(compiledMessage)).first->second;
+        if (static_cast<size_t>(type) >= byType.size()) {
+            byType.resize(static_cast<size_t>(type) + 1, nullptr);
+        }
+        byType[type] = &entry;
+        return entry;
     }
 
-private:
-    static CompiledMessage compileMessage(const json& definition) {
-        struct FieldInfo {
-            int key;
-            std::function<void(FastVector::ByteVector&, const DynamicPayload::FieldValue&)> serialize;
-            std::function<void(const FastVector::ByteVector&, size_t&, DynamicPayload::FieldValue&)> deserialize;
-        };
-        short type = definition["type"].get<short>();
-        std::vector<FieldInfo> fieldInfos;
-        size_t totalSize = 0;
-        int fieldIndex = 0;
-
-        for (const auto& [key, def_type] : definition["fields"].items()) {
-            if (def_type == "string") {
-                fieldInfos.push_back({
-                                             fieldIndex,
-                                             [](FastVector::ByteVector& data, const DynamicPayload::FieldValue& value) {
-                                                 NetworkMessages::BinaryData::append_bytes(data, std::get<std::string>(value));
-                                             },
-                                             [](const FastVector::ByteVector& data, size_t& offset, DynamicPayload::FieldValue& value) {
-                                                 value = NetworkMessages::BinaryData::read_bytes<std::string>(data, offset);
-                                             },
-
-                                     });
-                totalSize += 20;
-            } else if (def_type == "int") {
-                fieldInfos.push_back({
-                                             fieldIndex,
-                                             [](FastVector::ByteVector& data, const DynamicPayload::FieldValue& value) {
-                                                 NetworkMessages::BinaryData::append_bytes(data, std::get<int>(value));
-                                             },
-                                             [](const FastVector::ByteVector& data, size_t& offset, DynamicPayload::FieldValue& value) {
-                                                 value = NetworkMessages::BinaryData::read_bytes<int>(data, offset);
-                                             },
-
-                                     });
-                totalSize += sizeof(int);
-            } else if (def_type == "float") {
-                fieldInfos.push_back({
-                                             fieldIndex,
-                                             [](FastVector::ByteVector& data, const DynamicPayload::FieldValue& value) {
-                                                 NetworkMessages::BinaryData::append_bytes(data, std::get<float>(value));
-                                             },
-                                             [](const FastVector::ByteVector& data, size_t& offset, DynamicPayload::FieldValue& value) {
-                                                 value = NetworkMessages::BinaryData::read_bytes<float>(data, offset);
-                                             },
-
-                                     });
-                totalSize += sizeof(float);
+    static FieldProgram::Field parseField(const std::string& name, const std::string& type, const json& file, std::vector<std::string>& compiling) {
+        static const std::unordered_map<std::string, FieldType> builtins = {
+                {"bool", FieldType::Bool}, {"int8", FieldType::Int8}, {"int16", FieldType::Int16},
+                {"int32", FieldType::Int32}, {"int", FieldType::Int32}, {"int64", FieldType::Int64},
+                {"uint8", FieldType::UInt8}, {"uint16", FieldType::UInt16}, {"uint32", FieldType::UInt32},
+                {"uint64", FieldType::UInt64}, {"float", FieldType::Float}, {"double", FieldType::Double},
+                {"string", FieldType::String}, {"bytes", FieldType::Bytes}};
+
+        FieldProgram::Field field;
+        field.name = name;
+        std::string base = type;
+        size_t bracket = type.find('[');
+        if (bracket != std::string::npos) {
+            base = type.substr(0, bracket);
+            std::string length = type.substr(bracket + 1);
+            if (length.empty() || length.back() != ']') {
+                throw std::runtime_error("Invalid array type for field " + name + ": " + type);
             }
-            fieldIndex++;
+            length.pop_back();
+            if (length.empty()) {
+                field.repeated = true;
+            } else {
+                if (length.size() > 5 || length.find_first_not_of("0123456789") != std::string::npos ||
+                    std::stoul(length) == 0 || std::stoul(length) > 0xFFFF) {
+                    throw std::runtime_error("Invalid array length for field " + name + ": " + type);
+                }
+                field.count = static_cast<std::uint32_t>(std::stoul(length));
+            }
+        }
+
+        auto builtin = builtins.find(base);
+        if (builtin != builtins.end()) {
+            field.type = builtin->second;
+        } else {
+            field.type = FieldType::Message;
+            field.message = compileNamed(base, file, compiling).program;
         }
+        if (field.type == FieldType::Bytes && (field.repeated || field.count != 1)) {
+            throw std::runtime_error("Arrays of bytes are not supported, field " + name);
+        }
+        return field;
+    }
+
+    static CompiledMessage compileMessage(const json& definition, const json& file, std::vector<std::string>& compiling) {
+        short type = definition.at("type").get<short>();
+        auto program = std::make_shared<FieldProgram>();
+        size_t run = 0;  // Index of the open Block instruction, or code.size() if none
+        bool fixedSize = true;
+        size_t nestedSize = 0;  // Wire size of nested messages of fixed size
 
-        auto compiledSerialize = [fieldInfos, totalSize](const std::vector<DynamicPayload::FieldValue>& field_data) {
-            FastVector::ByteVector data;
-            data.reserve(totalSize);  // Pre-allocate for fixed-size fields
-            for (const auto& fieldInfo : fieldInfos) {
-                fieldInfo.serialize(data, field_data.at(fieldInfo.key));
+        for (const auto& [key, def_type] : definition.at("fields").items()) {
+            if (!def_type.is_string()) {
+                throw std::runtime_error("Unknown field type in message definition: " + def_type.dump());
             }
-            return data;
-        };
-
-        auto compiledDeserialize = [fieldInfos](const FastVector::ByteVector& data, std::vector<DynamicPayload::FieldValue>& field_data) {
-            size_t offset = 0;
-            field_data.reserve(fieldInfos.size());
-            for (const auto& fieldInfo : fieldInfos) {
-                DynamicPayload::FieldValue value;
-                fieldInfo.deserialize(data, offset, value);
-                field_data.emplace_back(std::move(value));
+            auto field = parseField(key, def_type.get<std::string>(), file, compiling);
+            auto slot = static_cast<std::uint16_t>(program->fields.size());
+            program->names.emplace(key, FieldHandle{slot});
+
+            size_t element = detail::scalar_size(field.type);
+            if (element != 0 && !field.repeated) {
+                size_t bytes = element * field.count;
+                field.fixed = true;
+                field.offset = static_cast<std::uint32_t>(program->blockSize);
+                if (run >= program->code.size()) {
+                    run = program->code.size();
+                    program->code.push_back({FieldProgram::Op::Block, slot, field.offset, 0});
+                }
+                program->code[run].size += static_cast<std::uint32_t>(bytes);
+                program->blockSize += bytes;
+                program->minWireSize += bytes;
+            } else {
+                FieldProgram::Op op;
+                if (field.type == FieldType::Message) {
+                    op = FieldProgram::Op::Messages;
+                    if (field.repeated || !field.message->wireSize) {
+                        fixedSize = false;
+                    } else {
+                        nestedSize += field.count * *field.message->wireSize;
+                    }
+                    program->minWireSize += field.repeated ? sizeof(uint32_t) : field.count * field.message->minWireSize;
+                } else if (field.type == FieldType::String && (field.repeated || field.count != 1)) {
+                    op = FieldProgram::Op::Strings;
+                    fixedSize = false;
+                    program->minWireSize += sizeof(uint32_t) * (field.repeated ? 1 : field.count);
+                } else {
+                    op = field.type == FieldType::String ? FieldProgram::Op::String
+                       : field.type == FieldType::Bytes ? FieldProgram::Op::Bytes : FieldProgram::Op::Array;
+                    fixedSize = false;
+                    program->minWireSize += sizeof(uint32_t);
+                }
+                field.offset = static_cast<std::uint32_t>(program->variableCount++);
+                program->code.push_back({op, slot, 0, 0});
+                run = program->code.size();
             }
-        };
+            program->fields.push_back(std::move(field));
+        }
+        if (fixedSize) {
+            program->wireSize = program->blockSize + nestedSize;
+        }
 
-        return CompiledMessage{definition, type, compiledSerialize, compiledDeserialize, static_cast<uint32_t>(fieldInfos.size())};
+        return CompiledMessage{definition, type, std::move(program)};
     }
 
     static inline std::unordered_map<std::string, CompiledMessage> definitions;
+    static inline std::vector<const CompiledMessage*> byType;
 };
 
+// Registers a handler on any MessageHandler<Endpoint> that calls back with the payload of
+// each frame of a type loaded into MessageFactory, decoded through its table of
+// definitions by type into a pooled message, and with the received frame itself, e.g. to
+// forward it unchanged. Both are only valid during the call.
+template<template<typename> class Handler, typename Endpoint>
+void registerPayloadHandler(Handler<Endpoint>& handler, short messageType,
+                            std::type_identity_t<std::function<void(const Endpoint&, const DynamicPayload&, const FastVector::ByteVector&)>> callback) {
+    handler.registerHandler(messageType, [messageType, callback = std::move(callback)](const Endpoint& endpoint, const FastVector::ByteVector& data) {
+        FastVector::ByteSpan payload(data.data() + sizeof(short), data.size() - sizeof(short));
+        auto message = MessageFactory::acquireMessage(messageType);
+        MessageFactory::decode(messageType, payload, message->getPayload());
+        callback(endpoint, message->getPayload(), data);
+    });
+}
+
+// Same, for callbacks that only need the payload
+template<template<typename> class Handler, typename Endpoint>
+void registerPayloadHandler(Handler<Endpoint>& handler, short messageType,
+                            std::type_identity_t<std::function<void(const Endpoint&, const DynamicPayload&)>> callback) {
+    registerPayloadHandler(handler, messageType, [callback = std::move(callback)](const Endpoint& endpoint, const DynamicPayload& payload, const FastVector::ByteVector&) {
+        callback(endpoint, payload);
+    });
+}
+
+// Helper function to populate payload fields, in definition order from the first slot
+template<typename... Args>
+void populatePayload(DynamicPayload& payload, Args&&... args) {
+    std::size_t index = 0;
+    (payload.set(payload.field(index++), std::forward<Args>(args)), ...);
+}
+
 // Helper function to create and populate messages
 template<typename... Args>
 std::shared_ptr<NetworkMessages::BinaryMessage<DynamicPayload>> createMessage(const std::string& name, Args&&... args) {
     auto msg = MessageFactory::createMessage(name);
-    auto& payload = msg->getPayload();
-    populatePayload(payload, std::forward<Args>(args)...);
+    populatePayload(msg->getPayload(), std::forward<Args>(args)...);
     return msg;
 }
-
-// Helper function to populate payload fields
-template<typename T, typename... Args>
-void populatePayload(DynamicPayload& payload, T&& value, Args&&... args) {
-    payload.set(std::forward<T>(value));
-    if constexpr (sizeof...(args) > 0) {
-        populatePayload(payload, std::forward<Args>(args)...);
-    }
 }
-}
\ No newline at end of file
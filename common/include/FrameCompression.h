@@ -0,0 +1,338 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "ByteSpan.h"
+#include "ByteVector.h"
+#include "FrameHeader.h"
+#include "Varint.h"
+
+
+namespace NetworkMessages
+{
+
+// Per-connection payload compression. Config keys, read by TCPServerBase and TCPClientBase:
+//   compress_frames     compress frames when the peer supports it (default false)
+//   compress_min_bytes  leave payloads smaller than this uncompressed (default 512)
+struct CompressionOptions {
+    bool enabled = false;
+    std::size_t min_bytes = 512;
+};
+
+// Bit 30 of the 4-byte size header marks a compressed frame; bit 31 still marks a batch,
+// so a compressed batch sets both (see FrameHeader.h). The payload
+// is the uncompressed size as a varint followed by one LZ4-format block. An empty
+// compressed frame is the hello a connection sends when compression is enabled; a peer
+// only compresses after it has received one, and frames it cannot shrink go out plain.
+// A peer built before compressed frames existed reads the hello as a 1 GiB plain frame,
+// so compress_frames must only be enabled on a client whose server understands it;
+// servers answer hellos rather than sending their own (see Connection::HelloRole).
+class CompressedFrame
+{
+public:
+    static constexpr std::uint32_t FLAG = FrameHeader::COMPRESSED_FLAG;
+
+    static bool isCompressed(std::uint32_t header) { return (header & FLAG) != 0; }
+};
+
+namespace detail
+{
+    // LZ4 block format: each sequence is a token (literal count, match length - 4), the
+    // literals, a 2-byte match offset and the match; counts of 15 and up continue in
+    // extra bytes. The last 5 bytes are always literals and the last match starts at
+    // least 12 bytes before the end, so both sides can copy in whole words.
+    constexpr std::size_t LZ_MIN_MATCH = 4;
+    constexpr std::size_t LZ_LAST_LITERALS = 5;
+    constexpr std::size_t LZ_MATCH_FIND_LIMIT = 12;
+    constexpr std::size_t LZ_MAX_OFFSET = 65535;
+    constexpr unsigned LZ_HASH_BITS = 12;
+
+    inline std::uint32_t lz_read32(const std::uint8_t* p) {
+        std::uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline std::uint32_t lz_hash(std::uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+    }
+
+    inline std::uint8_t* lz_write_length(std::uint8_t* op, std::size_t length) {
+        for (; length >= 255; length -= 255) {
+            *op++ = 255;
+        }
+        *op++ = static_cast<std::uint8_t>(length);
+        return op;
+    }
+
+    constexpr std::size_t lz_compress_bound(std::size_t size) {
+        return size + size / 255 + 16;
+    }
+}
+
+// Compresses the outgoing payloads of one connection. Matches may reach back into the
+// previous 64 KiB of compressed payloads, so repeated field names and values across
+// messages cost a few bytes each; the matching FrameDecompressor keeps the same history.
+// Both must see the same compressed frames in the same order.
+class FrameCompressor
+{
+public:
+    FrameCompressor() : table_(std::size_t{1} << detail::LZ_HASH_BITS, 0) {}
+
+    // Returns room for the next payload, which the caller fills before compressStaged()
+    std::uint8_t* stage(std::size_t size) {
+        if (history_.size() + size > HISTORY_CAPACITY && history_.size() > detail::LZ_MAX_OFFSET) {
+            std::size_t drop = history_.size() - detail::LZ_MAX_OFFSET;
+            history_.erase(history_.begin(), history_.begin() + drop);
+            base_ += static_cast<std::uint32_t>(drop);
+        }
+        if (base_ > REBASE_THRESHOLD) {
+            // Positions are 32-bit; start over before they wrap
+            std::fill(table_.begin(), table_.end(), 0);
+            history_.clear();
+            base_ = 0;
+        }
+        staged_ = history_.size();
+        history_.resize_uninitialized(staged_ + size);
+        return history_.data() + staged_;
+    }
+
+    // Writes the staged payload to out in compressed form. Returns false and forgets the
+    // payload, so it is sent plain and left out of the history, if that is not smaller.
+    template<std::size_t InlineN>
+    bool compressStaged(FastVector::BasicByteVector<InlineN>& out) {
+        std::size_t size = history_.size() - staged_;
+        std::size_t header = FastVector::varint_size(size);
+        out.resize_uninitialized(header + detail::lz_compress_bound(size));
+        FastVector::encode_varint(size, out.data());
+        std::size_t length = header + compress_block(out.data() + header);
+        if (length >= size) {
+            history_.resize_uninitialized(staged_);
+            return false;
+        }
+        out.resize_uninitialized(length);
+        return true;
+    }
+
+    template<std::size_t InlineN>
+    bool compress(FastVector::ByteSpan payload, FastVector::BasicByteVector<InlineN>& out) {
+        if (!payload.empty()) {
+            std::memcpy(stage(payload.size()), payload.data(), payload.size());
+        } else {
+            stage(0);
+        }
+        return compressStaged(out);
+    }
+
+private:
+    static constexpr std::size_t HISTORY_CAPACITY = 256 * 1024;
+    static constexpr std::uint32_t REBASE_THRESHOLD = 0x40000000u;
+
+    // Greedy single-probe matching; the step grows while nothing matches, so data that
+    // does not compress is skipped through quickly
+    std::size_t compress_block(std::uint8_t* out) {
+        using namespace detail;
+        const std::uint8_t* base = history_.data();
+        std::size_t end = history_.size();
+        std::size_t anchor = staged_;
+        std::uint8_t* op = out;
+
+        if (end - staged_ > LZ_MATCH_FIND_LIMIT) {
+            std::size_t match_limit = end - LZ_MATCH_FIND_LIMIT;
+            std::size_t copy_limit = end - LZ_LAST_LITERALS;
+            std::size_t ip = staged_;
+            unsigned attempts = 1u << 6;
+
+            while (ip < match_limit) {
+                std::uint32_t sequence = lz_read32(base + ip);
+                std::uint32_t& slot = table_[lz_hash(sequence)];
+                std::uint32_t candidate = slot;
+                std::uint32_t position = base_ + static_cast<std::uint32_t>(ip);
+                slot = position;
+                if (candidate < base_ || candidate >= position || position - candidate > LZ_MAX_OFFSET ||
+                    lz_read32(base + (candidate - base_)) != sequence) {
+                    ip += attempts++ >> 6;
+                    continue;
+                }
+                attempts = 1u << 6;
+
+                std::size_t match = candidate - base_;
+                while (ip > anchor && match > 0 && base[ip - 1] == base[match - 1]) {
+                    --ip;
+                    --match;
+                }
+                std::size_t length = LZ_MIN_MATCH;
+                while (ip + length < copy_limit && base[ip + length] == base[match + length]) {
+                    ++length;
+                }
+
+                op = write_sequence(op, base + anchor, ip - anchor, ip - match, length);
+                ip += length;
+                anchor = ip;
+                if (ip < match_limit) {
+                    table_[lz_hash(lz_read32(base + ip - 2))] = base_ + static_cast<std::uint32_t>(ip - 2);
+                }
+            }
+        }
+
+        std::size_t literals = end - anchor;
+        std::uint8_t* token = op++;
+        *token = static_cast<std::uint8_t>((literals < 15 ? literals : 15) << 4);
+        if (literals >= 15) {
+            op = lz_write_length(op, literals - 15);
+        }
+        std::memcpy(op, base + anchor, literals);
+        return static_cast<std::size_t>(op + literals - out);
+    }
+
+    static std::uint8_t* write_sequence(std::uint8_t* op, const std::uint8_t* literals, std::size_t literal_count,
+                                        std::size_t offset, std::size_t match_length) {
+        std::uint8_t* token = op++;
+        std::size_t extra = match_length - detail::LZ_MIN_MATCH;
+        *token = static_cast<std::uint8_t>(((literal_count < 15 ? literal_count : 15) << 4) | (extra < 15 ? extra : 15));
+        if (literal_count >= 15) {
+            op = detail::lz_write_length(op, literal_count - 15);
+        }
+        std::memcpy(op, literals, literal_count);
+        op += literal_count;
+        *op++ = static_cast<std::uint8_t>(offset & 0xFF);
+        *op++ = static_cast<std::uint8_t>(offset >> 8);
+        if (extra >= 15) {
+            op = detail::lz_write_length(op, extra - 15);
+        }
+        return op;
+    }
+
+    FastVector::HeapByteVector history_;
+    std::vector<std::uint32_t> table_;
+    std::uint32_t base_ = 0;  // Stream position of history_[0]
+    std::size_t staged_ = 0;
+};
+
+// Restores payloads written by a FrameCompressor. Every offset and length is checked,
+// so a malformed frame throws std::runtime_error instead of reading or writing out of
+// bounds; the connection is expected to close after that. Frames that claim more than
+// max_size uncompressed bytes are rejected before anything is allocated for them; the
+// default is the largest payload a plain frame can carry.
+class FrameDecompressor
+{
+public:
+    explicit FrameDecompressor(std::size_t max_size = FrameHeader::SIZE_MASK) : max_size_(max_size) {}
+
+    void setMaxSize(std::size_t max_size) { max_size_ = max_size; }
+
+    template<std::size_t InlineN>
+    void decompress(FastVector::ByteSpan frame, FastVector::BasicByteVector<InlineN>& out) {
+        std::uint64_t size = 0;
+        std::size_t header = FastVector::decode_varint(frame.data(), frame.size(), size);
+        if (header == 0) {
+            throw std::runtime_error("Invalid compressed frame size");
+        }
+        std::size_t block_size = frame.size() - header;
+        // No sequence expands by more than 255 times its encoded size
+        if (size > static_cast<std::uint64_t>(block_size) * 255) {
+            throw std::runtime_error("Compressed frame size out of range");
+        }
+        if (size > max_size_) {
+            throw std::runtime_error("Compressed frame too large");
+        }
+
+        if (history_.size() + size > HISTORY_CAPACITY && history_.size() > detail::LZ_MAX_OFFSET) {
+            history_.erase(history_.begin(), history_.end() - detail::LZ_MAX_OFFSET);
+        }
+        std::size_t start = history_.size();
+        history_.resize_uninitialized(start + static_cast<std::size_t>(size));
+        try {
+            decompress_block(frame.data() + header, block_size, start);
+        } catch (...) {
+            history_.resize_uninitialized(start);
+            throw;
+        }
+        out.resize_uninitialized(static_cast<std::size_t>(size));
+        if (size != 0) {
+            std::memcpy(out.data(), history_.data() + start, static_cast<std::size_t>(size));
+        }
+    }
+
+private:
+    static constexpr std::size_t HISTORY_CAPACITY = 256 * 1024;
+
+    void decompress_block(const std::uint8_t* ip, std::size_t size, std::size_t start) {
+        const std::uint8_t* const input_end = ip + size;
+        std::uint8_t* const base = history_.data();
+        std::uint8_t* op = base + start;
+        std::uint8_t* const output_end = base + history_.size();
+
+        auto read_length = [&](std::size_t length) {
+            std::uint8_t byte;
+            do {
+                if (ip == input_end) {
+                    throw std::runtime_error("Truncated compressed frame");
+                }
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+            return length;
+        };
+
+        while (true) {
+            if (ip == input_end) {
+                throw std::runtime_error("Truncated compressed frame");
+            }
+            std::uint8_t token = *ip++;
+            std::size_t literals = token >> 4;
+            if (literals == 15) {
+                literals = read_length(literals);
+            }
+            if (literals > static_cast<std::size_t>(input_end - ip) || literals > static_cast<std::size_t>(output_end - op)) {
+                throw std::runtime_error("Compressed frame literals run past the end");
+            }
+            std::memcpy(op, ip, literals);
+            ip += literals;
+            op += literals;
+            if (ip == input_end) {
+                break;
+            }
+
+            if (input_end - ip < 2) {
+                throw std::runtime_error("Truncated compressed frame");
+            }
+            std::size_t offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+            ip += 2;
+            std::size_t length = token & 15;
+            if (length == 15) {
+                length = read_length(length);
+            }
+            length += detail::LZ_MIN_MATCH;
+            if (offset == 0 || offset > static_cast<std::size_t>(op - base)) {
+                throw std::runtime_error("Compressed frame match offset out of range");
+            }
+            if (length > static_cast<std::size_t>(output_end - op)) {
+                throw std::runtime_error("Compressed frame match runs past the end");
+            }
+            const std::uint8_t* match = op - offset;
+            if (offset >= length) {
+                std::memcpy(op, match, length);
+                op += length;
+            } else {
+                // Overlapping match, e.g. a run of one repeated byte
+                for (std::size_t i = 0; i < length; ++i) {
+                    *op++ = *match++;
+                }
+            }
+        }
+
+        if (op != output_end) {
+            throw std::runtime_error("Compressed frame size mismatch");
+        }
+    }
+
+    FastVector::HeapByteVector history_;
+    std::size_t max_size_;
+};
+
+}
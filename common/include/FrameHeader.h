@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace NetworkMessages
+{
+
+// Every TCP frame starts with a 4-byte little-endian header. The low 30 bits hold the
+// payload size; bit 31 marks a batch frame (see BatchFrame.h) and bit 30 a compressed
+// one (see FrameCompression.h), so a single frame carries at most 1 GiB - 1 bytes.
+struct FrameHeader
+{
+    static constexpr std::size_t SIZE = 4;
+    static constexpr std::uint32_t SIZE_MASK = 0x3FFFFFFFu;
+    static constexpr std::uint32_t BATCH_FLAG = 0x80000000u;
+    static constexpr std::uint32_t COMPRESSED_FLAG = 0x40000000u;
+
+    static constexpr std::uint32_t payloadSize(std::uint32_t header) { return header & SIZE_MASK; }
+};
+
+}
@@ -4,7 +4,7 @@
 #include <string>
 #include "BinaryData.h"
 
-class HTTPBody : public NetworkMessages::HTTPBinaryData {
+class HTTPBody {
 public:
     void setContent(const std::string& content) {
         m_content = content;
@@ -14,19 +14,13 @@ public:
         return m_content;
     }
 
-    [[nodiscard]] FastVector::ByteVector serialize() override {
-        FastVector::ByteVector data;
-        append_bytes(data, m_content);
-        return data;
+    // Moves the content out of a body that is about to be discarded
+    [[nodiscard]] std::string takeContent() && {
+        return std::move(m_content);
     }
 
-    void deserialize(const FastVector::ByteVector& data) override {
-        int offset = 0;
-        while (offset < data.size())
-        {
-            m_content += read_bytes(data, offset);
-        }
-
+    void deserialize(FastVector::ByteSpan data) {
+        m_content.assign(data.begin(), data.end());
     }
 
 private:
@@ -19,7 +19,12 @@ public:
         initializeClient();
     }
 
-    std::future<HTTPMessage> sendRequest(HTTPMessage& request) {
+    std::future<HTTPMessage> sendRequest(const HTTPMessage& request) {
+        return sendRequest(HTTPMessage(request));
+    }
+
+    // Takes over the request, so its body is written without being copied
+    std::future<HTTPMessage> sendRequest(HTTPMessage&& request) {
         auto promise = std::make_shared<std::promise<HTTPMessage>>();
         auto future = promise->get_future();
 
@@ -28,7 +33,7 @@ public:
             return future;
         }
 
-        m_connection->write(request);
+        m_connection->write(std::move(request));
 
         m_connection->read([promise](const HTTPMessage& response) {
             promise->set_value(response);
@@ -100,13 +105,12 @@ private:
         if (!body.empty()) {
             HTTPBody httpBody;
             httpBody.setContent(body);
-            request.setBody(httpBody);
-            FastVector::ByteVector serializedBody = httpBody.serialize();
-            request.addHeader("Content-Length", std::to_string(serializedBody.size()));
+            request.setBody(std::move(httpBody));
+            request.addHeader("Content-Length", std::to_string(body.size()));
             request.addHeader("Content-Type", "text/plain");
         }
 
-        auto future = sendRequest(request);
+        auto future = sendRequest(std::move(request));
 
         return future;
     }
@@ -6,7 +6,7 @@
 #include <algorithm>
 #include "BinaryData.h"
 
-class HTTPHeader : public NetworkMessages::HTTPBinaryData {
+class HTTPHeader {
 public:
     enum class Type {
         REQUEST,
@@ -63,38 +63,46 @@ public:
         return m_headers;
     }
 
-    [[nodiscard]] FastVector::ByteVector serialize() override {
-        FastVector::ByteVector data;
-        std::string startLine;
-
+    // Request or status line, without the terminating CRLF
+    [[nodiscard]] std::string startLine() const {
         if (isHttpMethod(methodToString(m_method))) {
-            startLine = methodToString(m_method) + " " + m_url.getPath() + " " + m_version;
-        } else {
-            startLine = m_version + " " + std::to_string(m_statusCode) + " " + m_statusMessage;
+            return methodToString(m_method) + " " + m_url.getPath() + " " + m_version;
         }
-        setFirstLine(startLine);
+        return m_version + " " + std::to_string(m_statusCode) + " " + m_statusMessage;
+    }
 
-        append_bytes(data, firstLine);
+    // Header fields, each terminated by CRLF, followed by the empty line ending the header block
+    [[nodiscard]] std::string serializeFields() const {
+        std::string fields;
         for (const auto& [key, value] : m_headers) {
-            std::string header = key + ": " + value;
-            append_bytes(data, header);
+            fields.append(key).append(": ").append(value).append("\r\n");
         }
-        std::string str;
-        append_bytes(data, str);
-        return data;
+        fields.append("\r\n");
+        return fields;
     }
 
-    void deserialize(const FastVector::ByteVector& data) override {
-        int offset = 0;
-        std::string line;
-        line = read_bytes(data, offset);
-        setFirstLine(line); // This will now parse the type as well
-        while ((line = read_bytes(data, offset)).empty()) {
+    // Parses the start line and header fields as received, one CRLF-terminated line each
+    void deserialize(FastVector::ByteSpan data) {
+        std::string text(data.begin(), data.end());
+        size_t lineStart = 0;
+        bool firstLineRead = false;
+        while (lineStart < text.size()) {
+            size_t lineEnd = text.find("\r\n", lineStart);
+            if (lineEnd == std::string::npos) {
+                lineEnd = text.size();
+            }
+            std::string line = text.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 2;
+
+            if (!firstLineRead) {
+                setFirstLine(line); // This will now parse the type as well
+                firstLineRead = true;
+                continue;
+            }
             size_t colonPos = line.find(':');
             if (colonPos != std::string::npos) {
-                std::string key = line.substr(0, colonPos);
-                std::string value = line.substr(colonPos + 2, line.length() - colonPos - 4); // -4 to remove \r\n
-                m_headers[key] = value;
+                size_t valuePos = line.find_first_not_of(' ', colonPos + 1);
+                m_headers[line.substr(0, colonPos)] = valuePos == std::string::npos ? "" : line.substr(valuePos);
             }
         }
     }
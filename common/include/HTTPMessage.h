@@ -4,6 +4,7 @@
 #include <utility>
 #include <vector>
 #include "BinaryData.h"
+#include "BufferChain.h"
 #include "HTTPUrl.h"
 #include "HTTPHeader.h"
 #include "HTTPBody.h"
@@ -33,18 +34,23 @@ public:
     [[nodiscard]] const HTTPHeader& getHeader() const { return m_headers; }
     [[nodiscard]] const HTTPBody& getBody() const { return m_body; }
 
-    [[nodiscard]] FastVector::ByteVector serialize()  {
-        FastVector::ByteVector data;
-
-        // Serialize headers
-        auto headerData = m_headers.serialize();
-        data.insert(data.end(), headerData.begin(), headerData.end());
-
-        // Serialize body
-        auto bodyData = m_body.serialize();
-        data.insert(data.end(), bodyData.begin(), bodyData.end());
+    // Start line, header block and body become separate segments of one chain. This
+    // overload copies the body, since the message stays usable afterwards.
+    [[nodiscard]] FastVector::BufferChain serialize() const & {
+        FastVector::BufferChain chain;
+        chain.append(m_headers.startLine() + "\r\n");
+        chain.append(m_headers.serializeFields());
+        chain.append(std::string(m_body.getContent()));
+        return chain;
+    }
 
-        return data;
+    // Moves the body into the chain instead of copying it
+    [[nodiscard]] FastVector::BufferChain serialize() && {
+        FastVector::BufferChain chain;
+        chain.append(m_headers.startLine() + "\r\n");
+        chain.append(m_headers.serializeFields());
+        chain.append(std::move(m_body).takeContent());
+        return chain;
     }
 
 
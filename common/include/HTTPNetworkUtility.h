@@ -15,6 +15,8 @@
 
 #include "Utilities.h"
 #include "Logger.h"
+#include "BufferChain.h"
+#include "HTTPMessage.h"
 
 class HTTPNetworkUtility {
 public:
@@ -30,17 +32,13 @@ public:
 
         asio::ip::tcp::socket& socket() { return socket_; }
 
-        void write(HTTPMessage& message) {
-            FastVector::ByteVector messageData = message.serialize();
-            LOG_DEBUG("Connection::write called. Message size: %zu", messageData.size());
+        void write(const HTTPMessage& message) {
+            queue_write(message.serialize());
+        }
 
-            asio::post(strand_, [this, messageData = messageData]() mutable {
-                bool write_in_progress = !write_queue_.empty();
-                write_queue_.push_back(messageData);
-                if (!write_in_progress) {
-                    do_write();
-                }
-            });
+        // Takes over the message, so its body is queued without being copied
+        void write(HTTPMessage&& message) {
+            queue_write(std::move(message).serialize());
         }
 
         void read(const std::function<void(HTTPMessage httpMessage)>& callback) {
@@ -89,9 +87,21 @@ public:
         }
 
     private:
+        void queue_write(FastVector::BufferChain messageData) {
+            LOG_DEBUG("Connection::write called. Message size: %zu", messageData.size());
+
+            asio::post(strand_, [this, messageData = std::move(messageData)]() mutable {
+                bool write_in_progress = !write_queue_.empty();
+                write_queue_.push_back(std::move(messageData));
+                if (!write_in_progress) {
+                    do_write();
+                }
+            });
+        }
+
         void do_write() {
-            auto& message = write_queue_.front();
-            asio::async_write(socket_, asio::buffer(message),
+            // The front chain stays queued until the write completes
+            asio::async_write(socket_, write_queue_.front().buffers(),
                               asio::bind_executor(strand_, [this, self = shared_from_this()](std::error_code ec, std::size_t length) {
                                   if (!ec) {
                                       LOG_DEBUG("Write completed. Length: %zu", length);
@@ -316,7 +326,7 @@ public:
         asio::ip::tcp::socket socket_;
         asio::strand<asio::io_context::executor_type> strand_;
         std::string read_buffer_;
-        std::deque<FastVector::ByteVector> write_queue_;
+        std::deque<FastVector::BufferChain> write_queue_;
         FastVector::ByteVector headers_;
     };
 
@@ -4,6 +4,7 @@
 #include "HTTPMessage.h"
 #include "AsioThreadPool.h"
 #include "Config.h"
+#include "MemoryPoolMonitor.h"
 #include <functional>
 #include <unordered_map>
 #include <memory>
@@ -34,11 +35,15 @@ public:
 
         LOG_INFO("Starting server on %s:%d", m_host.c_str(), m_port);
         startAccept();
+        m_memoryPoolMonitor->start();
         m_thread_pool->run();
     }
 
     void stop() {
         LOG_INFO("Stopping server");
+        if (m_memoryPoolMonitor) {
+            m_memoryPoolMonitor->stop();
+        }
         m_acceptor->close();
         if (m_thread_pool) {
             m_thread_pool->stop();
@@ -59,6 +64,7 @@ private:
         m_acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true));
         m_acceptor->bind(endpoint);
         m_acceptor->listen();
+        m_memoryPoolMonitor = std::make_unique<MemoryPoolMonitor>(m_thread_pool->get_io_context(), m_config);
     }
 
     void startAccept() {
@@ -84,8 +90,7 @@ private:
 
             auto it = m_handlers.find({method, path});
             if (it != m_handlers.end()) {
-                HTTPMessage response = it->second(message);
-                sendResponse(connection, response);
+                sendResponse(connection, it->second(message));
             } else {
                 sendNotFoundResponse(connection);
             }
@@ -99,8 +104,8 @@ private:
         });
     }
 
-    static void sendResponse(const std::shared_ptr<HTTPNetworkUtility::Connection>& connection, HTTPMessage& response) {
-        connection->write(response);
+    static void sendResponse(const std::shared_ptr<HTTPNetworkUtility::Connection>& connection, HTTPMessage&& response) {
+        connection->write(std::move(response));
     }
 
     static void sendNotFoundResponse(std::shared_ptr<HTTPNetworkUtility::Connection> connection) {
@@ -110,7 +115,7 @@ private:
         response.setStatusMessage("Not Found");
         response.addHeader("Content-Length", "0");
         response.addHeader("Connection", "close");
-        sendResponse(connection, response);
+        sendResponse(connection, std::move(response));
     }
 
     static bool shouldKeepAlive(const HTTPMessage& request) {
@@ -122,6 +127,7 @@ private:
     Config m_config;
     std::unique_ptr<AsioThreadPool> m_thread_pool;
     std::unique_ptr<asio::ip::tcp::acceptor> m_acceptor;
+    std::unique_ptr<MemoryPoolMonitor> m_memoryPoolMonitor;
     std::string m_host;
     int m_port{};
 
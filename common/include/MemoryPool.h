@@ -0,0 +1,488 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+
+namespace FastVector
+{
+
+// Size-classed slab allocator backing the heap storage of ByteVector.
+//
+// Requests are rounded up to a power-of-two size class between MIN_CLASS_SIZE and
+// MAX_CLASS_SIZE. Every class carves its blocks out of contiguous slabs, so a block
+// is always a single contiguous range of at least the requested size. Requests above
+// MAX_CLASS_SIZE take the large-object path and go straight to the global allocator.
+//
+// The pool does not store a header in front of a block: the class is recovered from
+// the size handed back to deallocate(), which must be the size returned by allocate().
+//
+// Each thread keeps a small magazine of free blocks per class in front of the shared
+// per-class depot. The common allocate/free path only touches the calling thread's
+// magazine and takes no lock; the depot mutex is taken once per batch when a magazine
+// runs empty (refill) or full (flush), and when a thread exits its magazines are
+// returned to the depot. Blocks may be freed on a different thread than the one that
+// allocated them.
+//
+// stats() reports reserved and in-use bytes, per-class allocation counts and the time
+// spent waiting for depot locks. Threads publish their counts whenever they touch the
+// depot, so in-use figures can lag by up to one magazine per thread. Slabs whose blocks
+// are all back in the depot can be released with trim(); a TrimPolicy decides how long
+// a class must have been idle first.
+class MemoryPool {
+public:
+    using size_type = std::size_t;
+
+    static constexpr size_type MIN_CLASS_SHIFT = 6;   // 64 B, small enough for heap-only vectors
+    static constexpr size_type MAX_CLASS_SHIFT = 20;  // 1 MiB
+    static constexpr size_type CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+    static constexpr size_type MIN_CLASS_SIZE = size_type(1) << MIN_CLASS_SHIFT;
+    static constexpr size_type MAX_CLASS_SIZE = size_type(1) << MAX_CLASS_SHIFT;
+    static constexpr size_type LARGE_CLASS = CLASS_COUNT;  // Class index of the large-object path
+    static constexpr size_type SLAB_SIZE = 256 * 1024;    // Classes smaller than this share a slab
+    static constexpr size_type MAGAZINE_BYTES = 128 * 1024;  // Bytes a thread may cache per class
+    static constexpr size_type MAX_MAGAZINE_SIZE = 32;
+
+    struct Block {
+        void* data;
+        size_type size;  // Usable capacity, always >= the requested size
+    };
+
+    struct ClassStats {
+        size_type block_size = 0;
+        std::uint64_t allocations = 0;
+        size_type blocks_in_use = 0;     // Handed out to callers
+        size_type free_blocks = 0;       // Sitting in the depot
+        size_type slabs = 0;
+        std::uint64_t lock_contentions = 0;
+        std::uint64_t lock_wait_ns = 0;
+    };
+
+    struct Stats {
+        size_type bytes_reserved = 0;    // Slabs plus live large objects
+        size_type bytes_in_use = 0;
+        size_type peak_bytes_reserved = 0;
+        size_type peak_bytes_in_use = 0;
+        std::uint64_t large_allocations = 0;
+        size_type large_bytes_in_use = 0;
+        std::uint64_t lock_wait_ns = 0;
+        std::array<ClassStats, CLASS_COUNT> classes{};
+    };
+
+    // A class is trimmed once nothing has been taken from its depot for cool_down.
+    // Trimming stops when the reserved footprint reaches retain_bytes.
+    struct TrimPolicy {
+        bool enabled = false;
+        std::chrono::milliseconds cool_down{30000};
+        size_type retain_bytes = 0;
+    };
+
+    static MemoryPool& getInstance() {
+        static MemoryPool instance;
+        return instance;
+    }
+
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    [[nodiscard]] Block allocate(size_type n) {
+        size_type index = classIndex(n);
+        if (index == LARGE_CLASS) {
+            large_allocations_.fetch_add(1, std::memory_order_relaxed);
+            large_bytes_in_use_.fetch_add(n, std::memory_order_relaxed);
+            add_in_use(static_cast<std::int64_t>(n));
+            add_reserved(n);
+            return {::operator new(n), n};
+        }
+
+        ThreadCache* cache = threadCache();
+        if (cache == nullptr || magazineCapacity(index) == 0) {
+            return {depot_pop(index), classSize(index)};
+        }
+
+        Magazine& magazine = cache->magazines[index];
+        ++magazine.allocations;
+        ++magazine.in_use_delta;
+        if (magazine.count == 0) {
+            refill(magazine, index);
+        }
+        return {magazine.blocks[--magazine.count], classSize(index)};
+    }
+
+    void deallocate(void* p, size_type size) {
+        if (p == nullptr) return;
+
+        size_type index = classIndex(size);
+        if (index == LARGE_CLASS) {
+            ::operator delete(p);
+            large_bytes_in_use_.fetch_sub(size, std::memory_order_relaxed);
+            add_in_use(-static_cast<std::int64_t>(size));
+            bytes_reserved_.fetch_sub(size, std::memory_order_relaxed);
+            return;
+        }
+
+        ThreadCache* cache = threadCache();
+        if (cache == nullptr || magazineCapacity(index) == 0) {
+            depot_push(index, p);
+            return;
+        }
+
+        Magazine& magazine = cache->magazines[index];
+        --magazine.in_use_delta;
+        if (magazine.count == magazineCapacity(index)) {
+            flush(magazine, index, magazine.count / 2);
+        }
+        magazine.blocks[magazine.count++] = p;
+    }
+
+    [[nodiscard]] Stats stats() {
+        Stats result;
+        for (size_type index = 0; index < CLASS_COUNT; ++index) {
+            SizeClass& size_class = classes_[index];
+            std::lock_guard<std::mutex> lock(size_class.mutex);
+            ClassStats& class_stats = result.classes[index];
+            class_stats.block_size = classSize(index);
+            class_stats.allocations = size_class.allocations;
+            class_stats.blocks_in_use = size_class.blocks_in_use > 0 ? static_cast<size_type>(size_class.blocks_in_use) : 0;
+            class_stats.free_blocks = size_class.free_blocks.size();
+            class_stats.slabs = size_class.slabs.size();
+            class_stats.lock_contentions = size_class.lock_contentions.load(std::memory_order_relaxed);
+            class_stats.lock_wait_ns = size_class.lock_wait_ns.load(std::memory_order_relaxed);
+            result.lock_wait_ns += class_stats.lock_wait_ns;
+        }
+        result.bytes_reserved = bytes_reserved_.load(std::memory_order_relaxed);
+        result.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+        result.peak_bytes_reserved = peak_bytes_reserved_.load(std::memory_order_relaxed);
+        result.peak_bytes_in_use = peak_bytes_in_use_.load(std::memory_order_relaxed);
+        result.large_allocations = large_allocations_.load(std::memory_order_relaxed);
+        result.large_bytes_in_use = large_bytes_in_use_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    // Human-readable snapshot of stats(), one line per size class that has been used
+    [[nodiscard]] std::string dumpStats() {
+        Stats snapshot = stats();
+        std::string out;
+        char line[192];
+        std::snprintf(line, sizeof(line),
+                      "MemoryPool: reserved %zu KiB (peak %zu KiB), in use %zu KiB (peak %zu KiB), "
+                      "large allocations %llu, lock wait %.3f ms\n",
+                      snapshot.bytes_reserved / 1024, snapshot.peak_bytes_reserved / 1024,
+                      snapshot.bytes_in_use / 1024, snapshot.peak_bytes_in_use / 1024,
+                      static_cast<unsigned long long>(snapshot.large_allocations),
+                      static_cast<double>(snapshot.lock_wait_ns) / 1e6);
+        out += line;
+        for (const ClassStats& class_stats : snapshot.classes) {
+            if (class_stats.allocations == 0 && class_stats.slabs == 0) continue;
+            std::snprintf(line, sizeof(line),
+                          "  %8zu B: allocations %llu, in use %zu, free %zu, slabs %zu, contended locks %llu\n",
+                          class_stats.block_size, static_cast<unsigned long long>(class_stats.allocations),
+                          class_stats.blocks_in_use, class_stats.free_blocks, class_stats.slabs,
+                          static_cast<unsigned long long>(class_stats.lock_contentions));
+            out += line;
+        }
+        return out;
+    }
+
+    void setTrimPolicy(const TrimPolicy& policy) {
+        std::lock_guard<std::mutex> lock(policy_mutex_);
+        trim_policy_ = policy;
+    }
+
+    TrimPolicy trimPolicy() {
+        std::lock_guard<std::mutex> lock(policy_mutex_);
+        return trim_policy_;
+    }
+
+    // Applies the trim policy; returns the number of bytes given back
+    size_type trim() {
+        TrimPolicy policy = trimPolicy();
+        if (!policy.enabled) return 0;
+        return trim(policy.cool_down, policy.retain_bytes);
+    }
+
+    // Releases every slab whose blocks are all in the depot, for classes that have seen
+    // no depot demand for at least cool_down. Blocks cached in thread magazines keep
+    // their slab alive. Returns the number of bytes given back.
+    size_type trim(std::chrono::milliseconds cool_down, size_type retain_bytes = 0) {
+        auto now = std::chrono::steady_clock::now();
+        size_type released = 0;
+        // Largest classes first, they free the most memory per slab
+        for (size_type index = CLASS_COUNT; index > 0; --index) {
+            if (bytes_reserved_.load(std::memory_order_relaxed) <= retain_bytes) break;
+            SizeClass& size_class = classes_[index - 1];
+            auto lock = lock_class(size_class);
+            if (now - size_class.last_demand < cool_down) continue;
+            released += release_free_slabs(size_class, index - 1, retain_bytes);
+        }
+        return released;
+    }
+    // Index of the smallest class that fits n bytes, or LARGE_CLASS
+    static constexpr size_type classIndex(size_type n) {
+        if (n > MAX_CLASS_SIZE) return LARGE_CLASS;
+        size_type index = 0;
+        while ((MIN_CLASS_SIZE << index) < n) {
+            ++index;
+        }
+        return index;
+    }
+
+    static constexpr size_type classSize(size_type index) {
+        return MIN_CLASS_SIZE << index;
+    }
+
+    // Capacity a request of n bytes will actually receive
+    static constexpr size_type roundUp(size_type n) {
+        size_type index = classIndex(n);
+        return index == LARGE_CLASS ? n : classSize(index);
+    }
+
+    // Number of blocks a thread caches for a class; classes whose blocks are larger than
+    // MAGAZINE_BYTES bypass the thread cache and always go to the depot
+    static constexpr size_type magazineCapacity(size_type index) {
+        size_type capacity = MAGAZINE_BYTES / classSize(index);
+        if (capacity == 0) return 0;
+        if (capacity < 2) return 2;
+        return capacity < MAX_MAGAZINE_SIZE ? capacity : MAX_MAGAZINE_SIZE;
+    }
+
+private:
+    struct SizeClass {
+        std::mutex mutex;
+        std::vector<void*> free_blocks;
+        std::vector<void*> slabs;
+        // Guarded by mutex
+        std::uint64_t allocations = 0;
+        std::int64_t blocks_in_use = 0;
+        std::chrono::steady_clock::time_point last_demand{};
+        // Updated while waiting for mutex
+        std::atomic<std::uint64_t> lock_contentions{0};
+        std::atomic<std::uint64_t> lock_wait_ns{0};
+    };
+
+    struct Magazine {
+        std::array<void*, MAX_MAGAZINE_SIZE> blocks;
+        size_type count = 0;
+        // Counts not yet published to the depot, see publish()
+        std::uint64_t allocations = 0;
+        std::int64_t in_use_delta = 0;
+    };
+
+    struct ThreadCache {
+        std::array<Magazine, CLASS_COUNT> magazines;
+
+        ~ThreadCache() {
+            MemoryPool& pool = getInstance();
+            for (size_type index = 0; index < CLASS_COUNT; ++index) {
+                Magazine& magazine = magazines[index];
+                if (magazine.count > 0 || magazine.allocations > 0 || magazine.in_use_delta != 0) {
+                    pool.flush(magazine, index, magazine.count);
+                }
+            }
+            cache_destroyed() = true;
+        }
+    };
+
+    // Returns nullptr once the calling thread's cache has been torn down, so frees from
+    // other thread-exit destructors still land in the depot
+    static ThreadCache* threadCache() {
+        if (cache_destroyed()) return nullptr;
+        thread_local ThreadCache cache;
+        return &cache;
+    }
+
+    static bool& cache_destroyed() {
+        thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    MemoryPool() = default;
+
+    ~MemoryPool() {
+        for (SizeClass& size_class : classes_) {
+            for (void* slab : size_class.slabs) {
+                ::operator delete(slab);
+            }
+        }
+    }
+
+    // Moves half a magazine's worth of blocks from the depot into an empty magazine
+    void refill(Magazine& magazine, size_type index) {
+        size_type batch = magazineCapacity(index) / 2;
+        SizeClass& size_class = classes_[index];
+        auto lock = lock_class(size_class);
+        publish(magazine, size_class, index);
+        size_class.last_demand = std::chrono::steady_clock::now();
+        if (size_class.free_blocks.size() < batch) {
+            allocate_slab(size_class, index);
+        }
+        size_type take = std::min(batch, size_class.free_blocks.size());
+        for (size_type i = 0; i < take; ++i) {
+            magazine.blocks[magazine.count++] = size_class.free_blocks.back();
+            size_class.free_blocks.pop_back();
+        }
+    }
+
+    // Returns the most recently cached count blocks of a magazine to the depot
+    void flush(Magazine& magazine, size_type index, size_type count) {
+        SizeClass& size_class = classes_[index];
+        auto lock = lock_class(size_class);
+        publish(magazine, size_class, index);
+        for (size_type i = 0; i < count; ++i) {
+            size_class.free_blocks.push_back(magazine.blocks[--magazine.count]);
+        }
+    }
+
+    void* depot_pop(size_type index) {
+        SizeClass& size_class = classes_[index];
+        auto lock = lock_class(size_class);
+        size_class.last_demand = std::chrono::steady_clock::now();
+        ++size_class.allocations;
+        ++size_class.blocks_in_use;
+        add_in_use(static_cast<std::int64_t>(classSize(index)));
+        if (size_class.free_blocks.empty()) {
+            allocate_slab(size_class, index);
+        }
+        void* result = size_class.free_blocks.back();
+        size_class.free_blocks.pop_back();
+        return result;
+    }
+
+    void depot_push(size_type index, void* p) {
+        SizeClass& size_class = classes_[index];
+        auto lock = lock_class(size_class);
+        --size_class.blocks_in_use;
+        add_in_use(-static_cast<std::int64_t>(classSize(index)));
+        size_class.free_blocks.push_back(p);
+    }
+
+    // Takes the class mutex, timing the wait only when the lock is contended
+    static std::unique_lock<std::mutex> lock_class(SizeClass& size_class) {
+        std::unique_lock<std::mutex> lock(size_class.mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            auto start = std::chrono::steady_clock::now();
+            lock.lock();
+            auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            size_class.lock_contentions.fetch_add(1, std::memory_order_relaxed);
+            size_class.lock_wait_ns.fetch_add(static_cast<std::uint64_t>(waited.count()), std::memory_order_relaxed);
+        }
+        return lock;
+    }
+
+    // Folds a magazine's pending counts into its class. Called with the class mutex held.
+    void publish(Magazine& magazine, SizeClass& size_class, size_type index) {
+        size_class.allocations += magazine.allocations;
+        size_class.blocks_in_use += magazine.in_use_delta;
+        add_in_use(magazine.in_use_delta * static_cast<std::int64_t>(classSize(index)));
+        magazine.allocations = 0;
+        magazine.in_use_delta = 0;
+    }
+
+    void add_in_use(std::int64_t delta) {
+        if (delta == 0) return;
+        size_type in_use = bytes_in_use_.fetch_add(static_cast<size_type>(delta), std::memory_order_relaxed)
+                           + static_cast<size_type>(delta);
+        if (delta > 0) {
+            raise_peak(peak_bytes_in_use_, in_use);
+        }
+    }
+
+    void add_reserved(size_type bytes) {
+        size_type reserved = bytes_reserved_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        raise_peak(peak_bytes_reserved_, reserved);
+    }
+
+    static void raise_peak(std::atomic<size_type>& peak, size_type value) {
+        size_type current = peak.load(std::memory_order_relaxed);
+        while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    static size_type blocks_per_slab(size_type index) {
+        size_type block_size = classSize(index);
+        return block_size < SLAB_SIZE ? SLAB_SIZE / block_size : 1;
+    }
+
+    // Called with the class mutex held
+    void allocate_slab(SizeClass& size_class, size_type index) {
+        size_type block_size = classSize(index);
+        size_type block_count = blocks_per_slab(index);
+
+        auto* slab = static_cast<std::uint8_t*>(::operator new(block_size * block_count));
+        add_reserved(block_size * block_count);
+        size_class.slabs.push_back(slab);
+        size_class.free_blocks.reserve(size_class.free_blocks.size() + block_count);
+        // Push in reverse so blocks are handed out in address order
+        for (size_type i = block_count; i > 0; --i) {
+            size_class.free_blocks.push_back(slab + (i - 1) * block_size);
+        }
+    }
+
+    // Deletes the slabs whose blocks are all in the depot free list. Both lists are sorted
+    // by address so each slab's free blocks form one contiguous run. Called with the class
+    // mutex held.
+    size_type release_free_slabs(SizeClass& size_class, size_type index, size_type retain_bytes) {
+        size_type block_size = classSize(index);
+        size_type block_count = blocks_per_slab(index);
+        size_type slab_bytes = block_size * block_count;
+        if (size_class.free_blocks.size() < block_count) return 0;
+
+        std::less<> before;
+        std::sort(size_class.slabs.begin(), size_class.slabs.end(), before);
+        std::sort(size_class.free_blocks.begin(), size_class.free_blocks.end(), before);
+
+        std::vector<void*> kept_slabs;
+        std::vector<void*> kept_blocks;
+        kept_blocks.reserve(size_class.free_blocks.size());
+        size_type released = 0;
+        auto block = size_class.free_blocks.begin();
+        for (void* slab : size_class.slabs) {
+            auto* first = static_cast<std::uint8_t*>(slab);
+            auto* last = first + slab_bytes;
+            auto run_begin = std::lower_bound(block, size_class.free_blocks.end(), static_cast<void*>(first), before);
+            auto run_end = std::lower_bound(run_begin, size_class.free_blocks.end(), static_cast<void*>(last), before);
+            kept_blocks.insert(kept_blocks.end(), block, run_begin);
+            block = run_end;
+
+            bool idle = static_cast<size_type>(run_end - run_begin) == block_count;
+            if (idle && bytes_reserved_.load(std::memory_order_relaxed) >= retain_bytes + slab_bytes) {
+                ::operator delete(slab);
+                bytes_reserved_.fetch_sub(slab_bytes, std::memory_order_relaxed);
+                released += slab_bytes;
+            } else {
+                kept_slabs.push_back(slab);
+                kept_blocks.insert(kept_blocks.end(), run_begin, run_end);
+            }
+        }
+        kept_blocks.insert(kept_blocks.end(), block, size_class.free_blocks.end());
+
+        size_class.slabs = std::move(kept_slabs);
+        size_class.free_blocks = std::move(kept_blocks);
+        return released;
+    }
+
+    std::array<SizeClass, CLASS_COUNT> classes_;
+
+    std::atomic<size_type> bytes_reserved_{0};
+    std::atomic<size_type> bytes_in_use_{0};
+    std::atomic<size_type> peak_bytes_reserved_{0};
+    std::atomic<size_type> peak_bytes_in_use_{0};
+    std::atomic<std::uint64_t> large_allocations_{0};
+    std::atomic<size_type> large_bytes_in_use_{0};
+
+    std::mutex policy_mutex_;
+    TrimPolicy trim_policy_;
+};
+
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <asio.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "Config.h"
+#include "Logger.h"
+#include "MemoryPool.h"
+
+// Periodic MemoryPool upkeep for a server: trims idle slabs according to the trim policy
+// and optionally logs a stats dump. Both run on a timer in the server's io_context.
+//
+// Config keys:
+//   memory_pool_trim_enabled       release idle slabs back to the OS (default false)
+//   memory_pool_trim_cool_down_ms  how long a size class must go without demand (default 30000)
+//   memory_pool_trim_interval_ms   how often to check (default 10000)
+//   memory_pool_retain_mb          footprint that is never trimmed (default 0)
+//   memory_pool_stats_interval_ms  log MemoryPool::dumpStats() this often, 0 to disable (default 0)
+class MemoryPoolMonitor {
+public:
+    MemoryPoolMonitor(asio::io_context& io_context, const Config& config)
+            : m_trimTimer(io_context), m_statsTimer(io_context) {
+        FastVector::MemoryPool::TrimPolicy policy;
+        policy.enabled = config.get<bool>("memory_pool_trim_enabled", false);
+        policy.cool_down = std::chrono::milliseconds(config.get<int>("memory_pool_trim_cool_down_ms", 30000));
+        policy.retain_bytes = static_cast<std::size_t>(config.get<float>("memory_pool_retain_mb", 0.0f) * (1024 * 1024));
+        FastVector::MemoryPool::getInstance().setTrimPolicy(policy);
+
+        m_trimInterval = std::chrono::milliseconds(config.get<int>("memory_pool_trim_interval_ms", 10000));
+        m_statsInterval = std::chrono::milliseconds(config.get<int>("memory_pool_stats_interval_ms", 0));
+    }
+
+    void start() {
+        if (FastVector::MemoryPool::getInstance().trimPolicy().enabled && m_trimInterval.count() > 0) {
+            scheduleTrim();
+        }
+        if (m_statsInterval.count() > 0) {
+            scheduleStats();
+        }
+    }
+
+    void stop() {
+        m_trimTimer.cancel();
+        m_statsTimer.cancel();
+    }
+
+private:
+    void scheduleTrim() {
+        m_trimTimer.expires_after(m_trimInterval);
+        m_trimTimer.async_wait([this](std::error_code ec) {
+            if (ec) return;
+            std::size_t released = FastVector::MemoryPool::getInstance().trim();
+            if (released > 0) {
+                LOG_DEBUG("MemoryPool trim released %zu KiB", released / 1024);
+            }
+            scheduleTrim();
+        });
+    }
+
+    void scheduleStats() {
+        m_statsTimer.expires_after(m_statsInterval);
+        m_statsTimer.async_wait([this](std::error_code ec) {
+            if (ec) return;
+            LOG_INFO("%s", FastVector::MemoryPool::getInstance().dumpStats().c_str());
+            scheduleStats();
+        });
+    }
+
+    asio::steady_timer m_trimTimer;
+    asio::steady_timer m_statsTimer;
+    std::chrono::milliseconds m_trimInterval{};
+    std::chrono::milliseconds m_statsInterval{};
+};
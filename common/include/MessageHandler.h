@@ -8,27 +8,44 @@
 #include "TCPNetworkUtility.h"
 #include "UDPNetworkUtility.h"
 #include <functional>
-#include <unordered_map>
 #include <memory>
+#include <vector>
 
+// Routes each message to the handler of its type. Handlers sit in a flat table indexed
+// by the type, so dispatching a frame is one bounds check and one indirect call.
 template<typename EndpointType>
 class MessageHandler {
 public:
     using MessageCallback = std::function<void(const EndpointType&, const FastVector::ByteVector&)>;
 
     void registerHandler(short messageType, MessageCallback callback) {
+        if (messageType < 0) {
+            throw std::runtime_error("Message type out of range: " + std::to_string(messageType));
+        }
+        if (static_cast<size_t>(messageType) >= m_handlers.size()) {
+            m_handlers.resize(static_cast<size_t>(messageType) + 1);
+        }
         m_handlers[messageType] = std::move(callback);
     }
 
+    // Calls back with Message::View decoded from each frame of that type. The view's
+    // strings and bytes point into the frame and are only valid during the call.
+    template<NetworkMessages::ReflectedMessage Message>
+    void registerViewHandler(std::function<void(const EndpointType&, const typename Message::View&)> callback) {
+        registerHandler(Message::MessageTypeId, [callback = std::move(callback)](const EndpointType& endpoint, const FastVector::ByteVector& data) {
+            callback(endpoint, NetworkMessages::deserializeMessage<typename Message::View>(data));
+        });
+    }
+
     void handleMessage(const EndpointType& endpoint, const FastVector::ByteVector& data) {
         try {
             NetworkMessages::MessageTypeData typeData;
-            typeData.deserialize(data);
+            size_t offset = 0;
+            typeData.deserialize(data, offset);
             short messageType = typeData.Type;
 
-            auto it = m_handlers.find(messageType);
-            if (it != m_handlers.end()) {
-                it->second(endpoint, data);
+            if (messageType >= 0 && static_cast<size_t>(messageType) < m_handlers.size() && m_handlers[messageType]) {
+                m_handlers[messageType](endpoint, data);
             } else {
                 LOG_ERROR("No handler registered for message type: %d", messageType);
             }
@@ -39,11 +56,11 @@ public:
 
 private:
 
-    std::unordered_map<short, MessageCallback> m_handlers;
+    std::vector<MessageCallback> m_handlers;  // By message type
 };
 
 // Specialization for TCP (using std::shared_ptr<NetworkUtility::Session> as endpoint)
 using TCPMessageHandler = MessageHandler<std::shared_ptr<TCPNetworkUtility::Session>>;
 
-// Specialization for UDP (using std::shared_ptr<UDPNetworkUtility::Session> as endpoint)
-using UDPMessageHandler = MessageHandler<std::shared_ptr<UDPNetworkUtility::Session>>;
+// Specialization for UDP (using the sender's address as endpoint)
+using UDPMessageHandler = MessageHandler<asio::ip::udp::endpoint>;
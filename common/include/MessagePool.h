@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "BinaryData.h"
+
+
+namespace NetworkMessages
+{
+
+namespace detail
+{
+    template<typename T>
+    struct is_binary_message : std::false_type {};
+
+    template<typename T>
+    struct is_binary_message<BinaryMessage<T>> : std::true_type {};
+
+    template<typename T>
+    void reset_message(T& message);
+
+    // Empties a field but keeps what it has allocated: strings and containers are cleared,
+    // fixed-length arrays and nested messages reset element by element
+    template<typename T>
+    void reset_field(T& field) {
+        if constexpr (ReflectedMessage<T> || requires { field.reset(); }) {
+            reset_message(field);
+        } else if constexpr (requires { field.clear(); }) {
+            field.clear();
+        } else if constexpr (requires { std::tuple_size<T>::value; field[0]; }) {
+            for (auto& element : field) {
+                reset_field(element);
+            }
+        } else {
+            field = T{};
+        }
+    }
+
+    template<typename T>
+    void reset_message(T& message) {
+        if constexpr (is_binary_message<T>::value) {
+            reset_field(message.getPayload());
+        } else if constexpr (requires { message.reset(); }) {
+            message.reset();
+        } else if constexpr (ReflectedMessage<T>) {
+            std::apply([&](auto... member) { (reset_field(message.*member), ...); }, MessageCodec<T>::fields);
+        } else {
+            message = T{};
+        }
+    }
+
+    template<typename T>
+    std::unique_ptr<T> make_pooled() {
+        if constexpr (is_binary_message<T>::value) {
+            using Payload = std::remove_cvref_t<decltype(std::declval<T&>().getPayload())>;
+            if constexpr (ReflectedMessage<Payload>) {
+                return std::make_unique<T>(Payload{});
+            } else {
+                return std::make_unique<T>(short{0}, Payload{});
+            }
+        } else {
+            return std::make_unique<T>();
+        }
+    }
+}
+
+// Recycles message objects of one type on one thread. acquire() hands out an instance
+// wrapped in a Handle; when the handle goes away the instance is reset and kept for the
+// next acquire(), together with the string and vector capacity it has built up, so a
+// steady stream of messages stops allocating once the pool has warmed up.
+//
+// Reset keeps the message type of a BinaryMessage, clears strings and containers and sets
+// every other field to its default; types with a reset() member provide their own.
+// A pool is meant to be used by the thread that owns it; local() returns that thread's
+// default pool for T. A handle released on another thread frees its object instead of
+// returning it, so handles may cross threads and outlive their pool.
+template<typename T>
+class MessagePool
+{
+    struct State {
+        std::vector<std::unique_ptr<T>> free;
+        std::size_t maxFree;
+        std::size_t created = 0;
+        std::size_t reused = 0;
+        std::thread::id owner = std::this_thread::get_id();
+    };
+
+public:
+    using Factory = std::function<std::unique_ptr<T>()>;
+
+    struct Stats {
+        std::size_t created = 0;  // Instances constructed because the pool was empty
+        std::size_t reused = 0;   // Acquires served from the pool
+        std::size_t free = 0;     // Instances waiting in the pool
+    };
+
+    class Handle
+    {
+    public:
+        Handle() = default;
+        Handle(Handle&&) noexcept = default;
+        Handle& operator=(Handle&& other) noexcept {
+            if (this != &other) {
+                recycle();
+                object_ = std::move(other.object_);
+                state_ = std::move(other.state_);
+            }
+            return *this;
+        }
+        ~Handle() { recycle(); }
+
+        T* get() const { return object_.get(); }
+        T& operator*() const { return *object_; }
+        T* operator->() const { return object_.get(); }
+        explicit operator bool() const { return object_ != nullptr; }
+
+    private:
+        friend class MessagePool;
+
+        Handle(std::unique_ptr<T> object, std::shared_ptr<State> state)
+                : object_(std::move(object)), state_(std::move(state)) {}
+
+        void recycle() {
+            if (!object_) {
+                return;
+            }
+            if (state_->owner == std::this_thread::get_id() && state_->free.size() < state_->maxFree) {
+                detail::reset_message(*object_);
+                state_->free.push_back(std::move(object_));
+            }
+            object_.reset();
+            state_.reset();
+        }
+
+        std::unique_ptr<T> object_;
+        std::shared_ptr<State> state_;
+    };
+
+    // factory builds an instance whenever the pool is empty; at most max_free released
+    // instances are kept, the rest are freed
+    explicit MessagePool(Factory factory = &detail::make_pooled<T>, std::size_t max_free = 64)
+            : factory_(std::move(factory)), state_(std::make_shared<State>()) {
+        state_->maxFree = max_free;
+    }
+
+    static MessagePool& local() {
+        thread_local MessagePool pool;
+        return pool;
+    }
+
+    Handle acquire() {
+        if (state_->free.empty()) {
+            ++state_->created;
+            return Handle(factory_(), state_);
+        }
+        ++state_->reused;
+        auto object = std::move(state_->free.back());
+        state_->free.pop_back();
+        return Handle(std::move(object), state_);
+    }
+
+    [[nodiscard]] Stats stats() const {
+        return Stats{state_->created, state_->reused, state_->free.size()};
+    }
+
+private:
+    Factory factory_;
+    std::shared_ptr<State> state_;
+};
+
+// Schema message from the calling thread's pool, with its type ID set
+template<ReflectedMessage T>
+typename MessagePool<BinaryMessage<T>>::Handle acquireMessage() {
+    return MessagePool<BinaryMessage<T>>::local().acquire();
+}
+
+}
@@ -0,0 +1,834 @@
+#pragma once
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <array>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ByteSpan.h"
+#include "ByteVector.h"
+#include "ByteWriter.h"
+#include "FrameHeader.h"
+#include "Utf8.h"
+#include "Varint.h"
+
+// Compile-time message schemas. A plain aggregate lists its wire fields once and gets
+// size, encode and decode generated from the list, with no virtual calls and no
+// temporary buffers:
+//
+//     struct ChatMessage {
+//         std::string username;
+//         std::string message;
+//         SERVERKIT_MESSAGE(ChatMessage, 0, username, message)
+//     };
+//
+// Fields are written in the listed order with the same encoding as BinaryData:
+// little-endian scalars, uint32 length-prefixed strings and byte vectors. Containers
+// are supported too: std::vector and maps as an element count followed by the
+// elements, std::array as its N elements, std::optional as a presence byte followed
+// by the value. A type can
+// also hand-write the hidden friend serverkit_fields() and MessageTypeId the macro
+// would generate.
+//
+// SERVERKIT_MESSAGE also declares Type::View, the same fields with strings as
+// std::string_view and byte vectors as FastVector::ByteSpan (nested messages as their
+// View). deserializeMessage<ChatMessage::View>(frame) decodes without allocating; the
+// views point into the frame and are only valid while its buffer is alive and unchanged.
+//
+// SERVERKIT_INTEGER_ENCODING(Varint) in the struct switches the message to compact
+// integers: integral fields wider than a byte become LEB128 varints (zigzag for signed
+// types) and string and byte vector lengths become varint counts. A single field can opt
+// in on its own by being declared as Varint<T>.
+
+namespace NetworkMessages
+{
+
+template<typename T>
+concept ReflectedMessage = requires(const T* message) {
+    { T::MessageTypeId } -> std::convertible_to<short>;
+    serverkit_fields(message);
+};
+
+enum class IntegerEncoding {
+    Fixed,   // Full-width little-endian, the BinaryData default
+    Varint   // LEB128, zigzag for signed values
+};
+
+// An integer that is always encoded as a varint, in schema messages and BinaryData alike
+template<typename T>
+struct Varint {
+    static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "Varint<T> wraps integer types");
+    using value_type = T;
+
+    T value{};
+
+    constexpr Varint() = default;
+    constexpr Varint(T v) : value(v) {}
+    constexpr operator T() const { return value; }
+};
+
+template<typename T>
+inline constexpr bool is_varint_v = false;
+
+template<typename T>
+inline constexpr bool is_varint_v<Varint<T>> = true;
+
+template<typename T>
+constexpr IntegerEncoding message_integer_encoding() {
+    if constexpr (requires { T::MessageIntegerEncoding; }) {
+        return T::MessageIntegerEncoding;
+    } else if constexpr (requires { typename T::ViewedMessage; }) {
+        return message_integer_encoding<typename T::ViewedMessage>();  // Views share the wire format
+    } else {
+        return IntegerEncoding::Fixed;
+    }
+}
+
+template<typename T>
+inline constexpr IntegerEncoding integer_encoding_v = message_integer_encoding<T>();
+
+template<typename T, IntegerEncoding Encoding = IntegerEncoding::Fixed>
+struct FieldCodec;
+
+template<typename T>
+struct MessageCodec;
+
+template<typename T>
+struct PackedMessage;
+
+template<typename T>
+concept PackedLayoutMessage = ReflectedMessage<T> && requires { T::PackedLayout; };
+
+namespace detail
+{
+    // Integers the varint policy applies to; single bytes gain nothing from it
+    template<typename T>
+    inline constexpr bool varint_eligible = std::is_integral_v<T> && !std::is_same_v<T, bool> && sizeof(T) > 1;
+
+    template<IntegerEncoding Encoding>
+    constexpr std::size_t length_prefix_size(std::size_t length) {
+        if constexpr (Encoding == IntegerEncoding::Varint) {
+            return FastVector::varint_size(length);
+        } else {
+            return sizeof(std::uint32_t);
+        }
+    }
+
+    template<IntegerEncoding Encoding>
+    void write_count(FastVector::ByteWriter& writer, std::size_t count) {
+        if constexpr (Encoding == IntegerEncoding::Varint) {
+            FastVector::write_varint(writer, count);
+        } else {
+            writer.write(static_cast<std::uint32_t>(count));
+        }
+    }
+
+    template<IntegerEncoding Encoding>
+    std::size_t read_count(FastVector::ByteReader& reader) {
+        if constexpr (Encoding == IntegerEncoding::Varint) {
+            return FastVector::from_varint_bits<std::uint32_t>(FastVector::read_varint(reader));
+        } else {
+            return reader.read<std::uint32_t>();
+        }
+    }
+
+    template<IntegerEncoding Encoding>
+    void write_length_prefixed(FastVector::ByteWriter& writer, const void* bytes, std::size_t length) {
+        write_count<Encoding>(writer, length);
+        writer.writeBytes(bytes, length);
+    }
+
+    template<IntegerEncoding Encoding>
+    FastVector::ByteSpan read_length_prefixed(FastVector::ByteReader& reader) {
+        if constexpr (Encoding == IntegerEncoding::Varint) {
+            return reader.readBytes(FastVector::from_varint_bits<std::uint32_t>(FastVector::read_varint(reader)));
+        } else {
+            return reader.readLengthPrefixed();
+        }
+    }
+}
+
+// Scalars and enums: fixed size, stored little-endian
+template<typename T, IntegerEncoding Encoding>
+    requires ((std::is_arithmetic_v<T> || std::is_enum_v<T>) &&
+              !(Encoding == IntegerEncoding::Varint && detail::varint_eligible<T>))
+struct FieldCodec<T, Encoding> {
+    static constexpr bool is_fixed_size = true;
+    static constexpr std::size_t fixed_size = sizeof(T);
+
+    static std::size_t size(const T&) { return sizeof(T); }
+
+    static void write(FastVector::ByteWriter& writer, const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            writer.write(static_cast<std::uint8_t>(value ? 1 : 0));
+        } else {
+            writer.write(value);
+        }
+    }
+
+    static void read(FastVector::ByteReader& reader, T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            value = reader.read<std::uint8_t>() != 0;
+        } else {
+            value = reader.read<T>();
+        }
+    }
+};
+
+// Integers under the varint policy
+template<typename T>
+    requires detail::varint_eligible<T>
+struct FieldCodec<T, IntegerEncoding::Varint> {
+    static constexpr bool is_fixed_size = false;
+    static constexpr std::size_t fixed_size = 0;
+
+    static std::size_t size(const T& value) { return FastVector::varint_size(FastVector::to_varint_bits(value)); }
+
+    static void write(FastVector::ByteWriter& writer, const T& value) {
+        FastVector::write_varint(writer, FastVector::to_varint_bits(value));
+    }
+
+    static void read(FastVector::ByteReader& reader, T& value) {
+        value = FastVector::from_varint_bits<T>(FastVector::read_varint(reader));
+    }
+};
+
+// Varint<T> fields are varints whatever the message policy
+template<typename T, IntegerEncoding Encoding>
+struct FieldCodec<Varint<T>, Encoding> {
+    using codec = FieldCodec<T, IntegerEncoding::Varint>;
+    static constexpr bool is_fixed_size = false;
+    static constexpr std::size_t fixed_size = 0;
+
+    static std::size_t size(const Varint<T>& value) { return codec::size(value.value); }
+    static void write(FastVector::ByteWriter& writer, const Varint<T>& value) { codec::write(writer, value.value); }
+    static void read(FastVector::ByteReader& reader, Varint<T>& value) { codec::read(reader, value.value); }
+};
+
+// UTF-8 strings: byte count, then the bytes unchanged
+template<IntegerEncoding Encoding>
+struct FieldCodec<std::string, Encoding> {
+    static constexpr bool is_fixed_size = false;
+    static constexpr std::size_t fixed_size = 0;
+
+    static std::size_t size(const std::string& value) {
+        return detail::length_prefix_size<Encoding>(value.size()) + value.size();
+    }
+
+    static void write(FastVector::ByteWriter& writer, const std::string& value) {
+        detail::write_length_prefixed<Encoding>(writer, value.data(), value.size());
+    }
+
+    static void read(FastVector::ByteReader& reader, std::string& value) {
+        FastVector::ByteSpan bytes = detail::read_length_prefixed<Encoding>(reader);
+        if (FastVector::utf8_validation_enabled() && !FastVector::is_valid_utf8(bytes.data(), bytes.size())) {
+            throw std::runtime_error("Invalid UTF-8 sequence");
+        }
+        value.assign(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+};
+
+// String views: encoded like std::string; decoding points into the received bytes
+template<IntegerEncoding Encoding>
+struct FieldCodec<std::string_view, Encoding> {
+    static constexpr bool is_fixed_size = false;
+    static constexpr std::size_t fixed_size = 0;
+
+    static std::size_t size(std::string_view value) {
+        return detail::length_prefix_size<Encoding>(value.size()) + value.size();
+    }
+
+    static void write(FastVector::ByteWriter& writer, std::string_view value) {
+        detail::write_length_prefixed<Encoding>(writer, value.data(), value.size());
+    }
+
+    static void read(FastVector::ByteReader& reader, std::string_view& value) {
+        FastVector::ByteSpan bytes = detail::read_length_prefixed<Encoding>(reader);
+        if (FastVector::utf8_validation_enabled() && !FastVector::is_valid_utf8(bytes.data(), bytes.size())) {
+            throw std::runtime_error("Invalid UTF-8 sequence");
+        }
+        value = std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+};
+
+// Byte views: encoded like a byte vector; decoding points into the received bytes
+template<IntegerEncoding Encoding>
+struct FieldCodec<FastVector::ByteSpan, Encoding> {
+    static constexpr bool is_fixed_size = false;
+    static constexpr std::size_t fixed_size = 0;
+
+    static std::size_t size(const FastVector::ByteSpan& value) {
+        return detail::length_prefix_size<Encoding>(value.size()) + value.size();
+    }
+
+    static void write(FastVector::ByteWriter& writer, const FastVector::ByteSpan& value) {
+        detail::write_length_prefixed<Encoding>(writer, value.data(), value.size());
+    }
+
+    static void read(FastVector::ByteReader& reader, FastVector::ByteSpan& value) {
+        value = detail::read_length_prefixed<Encoding>(reader);
+    }
+};
+
+// Opaque bytes: byte count, then the bytes
+template<std::size_t InlineN, IntegerEncoding Encoding>
+struct FieldCodec<FastVector::BasicByteVector<InlineN>, Encoding> {
+    using value_type = FastVector::BasicByteVector<InlineN>;
+    static constexpr bool is_fixed_size = false;
+    static constexpr std::size_t fixed_size = 0;
+
+    static std::size_t size(const value_type& value) {
+        return detail::length_prefix_size<Encoding>(value.size()) + value.size();
+    }
+
+    static void write(FastVector::ByteWriter& writer, const value_type& value) {
+        detail::write_length_prefixed<Encoding>(writer, value.data(), value.size());
+    }
+
+    static void read(FastVector::ByteReader& reader, value_type& value) {
+        FastVector::ByteSpan bytes = detail::read_length_prefixed<Encoding>(reader);
+        value.resize_uninitialized(bytes.size());
+        if (!bytes.empty()) {
+            std::memcpy(value.data(), bytes.data(), bytes.size());
+        }
+    }
+};
+
+// Nested messages are inlined field by field, without their type ID, and keep their
+// own integer encoding
+template<ReflectedMessage T, IntegerEncoding Encoding>
+struct FieldCodec<T, Encoding> {
+    static constexpr bool is_fixed_size = MessageCodec<T>::is_fixed_size;
+    static constexpr std::size_t fixed_size = MessageCodec<T>::fixed_bytes;
+
+    static std::size_t size(const T& value) { return MessageCodec<T>::size(value); }
+    static void write(FastVector::ByteWriter& writer, const T& value) { MessageCodec<T>::write(writer, value); }
+    static void read(FastVector::ByteReader& reader, T& value) { MessageCodec<T>::read(reader, value); }
+};
+
+namespace detail
+{
+    // Element types a container writes and reads as one block with writeArray/readArray
+    template<typename T, IntegerEncoding Encoding>
+    inline constexpr bool bulk_copyable = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+                                          !(Encoding == IntegerEncoding::Varint && varint_eligible<T>);
+
+    // Rejects element counts the remaining input cannot hold, before anything is allocated;
+    // every variable-size encoding takes at least one byte
+    template<typename Codec>
+    void check_count(const FastVector::ByteReader& reader, std::size_t count) {
+        constexpr std::size_t min_size = Codec::is_fixed_size ? Codec::fixed_size : 1;
+        if constexpr (min_size > 0) {
+            if (count > reader.remaining() / min_size) {
+                throw std::runtime_error("Element count exceeds the remaining data");
+            }
+        }
+    }
+
+    template<typename Codec, typename Range>
+    std::size_t elements_size(const Range& range) {
+        if constexpr (Codec::is_fixed_size) {
+            return std::size(range) * Codec::fixed_size;
+        } else {
+            std::size_t total = 0;
+            for (const auto& element : range) {
+                total += Codec::size(element);
+            }
+            return total;
+        }
+    }
+
+    // Writes then reads the elements of a vector or array
+    template<typename T, IntegerEncoding Encoding, typename Range>
+    void write_elements(FastVector::ByteWriter& writer, const Range& range) {
+        if constexpr (bulk_copyable<T, Encoding>) {
+            writer.writeArray(std::data(range), std::size(range));
+        } else {
+            for (const auto& element : range) {
+                FieldCodec<T, Encoding>::write(writer, element);
+            }
+        }
+    }
+
+    template<typename T, IntegerEncoding Encoding>
+    void read_elements(FastVector::ByteReader& reader, T* out, std::size_t count) {
+        if constexpr (bulk_copyable<T, Encoding>) {
+            reader.readArray(out, count);
+        } else if constexpr (Encoding == IntegerEncoding::Varint && varint_eligible<T>) {
+            FastVector::read_varints(reader, out, count);
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                FieldCodec<T, Encoding>::read(reader, out[i]);
+            }
+        }
+    }
+}
+
+// Vectors: element count, then the elements; arithmetic elements are one memcpy
+template<typename T, typename Allocator, IntegerEncoding Encoding>
+struct FieldCodec<std::vector<T, Allocator>, Encoding> {
+    using value_type = std::vector<T, Allocator>;
+    using element_codec = FieldCodec<T, Encoding>;
+    static constexpr bool is_fixed_size = false;
+    static constexpr std::size_t fixed_size = 0;
+
+    static std::size_t size(const value_type& value) {
+        return detail::length_prefix_size<Encoding>(value.size()) + detail::elements_size<element_codec>(value);
+    }
+
+    static void write(FastVector::ByteWriter& writer, const value_type& value) {
+        detail::write_count<Encoding>(writer, value.size());
+        if constexpr (std::is_same_v<T, bool>) {
+            for (bool element : value) {
+                element_codec::write(writer, element);
+            }
+        } else {
+            detail::write_elements<T, Encoding>(writer, value);
+        }
+    }
+
+    static void read(FastVector::ByteReader& reader, value_type& value) {
+        std::size_t count = detail::read_count<Encoding>(reader);
+        detail::check_count<element_codec>(reader, count);
+        if constexpr (std::is_same_v<T, bool>) {
+            value.clear();
+            value.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                bool element;
+                element_codec::read(reader, element);
+                value.push_back(element);
+            }
+        } else {
+            value.resize(count);
+            detail::read_elements<T, Encoding>(reader, value.data(), count);
+        }
+    }
+};
+
+// Fixed-length arrays: the N elements without a count
+template<typename T, std::size_t N, IntegerEncoding Encoding>
+struct FieldCodec<std::array<T, N>, Encoding> {
+    using value_type = std::array<T, N>;
+    using element_codec = FieldCodec<T, Encoding>;
+    static constexpr bool is_fixed_size = element_codec::is_fixed_size;
+    static constexpr std::size_t fixed_size = is_fixed_size ? N * element_codec::fixed_size : 0;
+
+    static std::size_t size(const value_type& value) { return detail::elements_size<element_codec>(value); }
+
+    static void write(FastVector::ByteWriter& writer, const value_type& value) {
+        detail::write_elements<T, Encoding>(writer, value);
+    }
+
+    static void read(FastVector::ByteReader& reader, value_type& value) {
+        detail::read_elements<T, Encoding>(reader, value.data(), N);
+    }
+};
+
+// Optionals: a presence byte (0 or 1), then the value if present
+template<typename T, IntegerEncoding Encoding>
+struct FieldCodec<std::optional<T>, Encoding> {
+    using value_type = std::optional<T>;
+    using element_codec = FieldCodec<T, Encoding>;
+    static constexpr bool is_fixed_size = false;
+    static constexpr std::size_t fixed_size = 0;
+
+    static std::size_t size(const value_type& value) {
+        return sizeof(std::uint8_t) + (value ? element_codec::size(*value) : 0);
+    }
+
+    static void write(FastVector::ByteWriter& writer, const value_type& value) {
+        writer.write(static_cast<std::uint8_t>(value ? 1 : 0));
+        if (value) {
+            element_codec::write(writer, *value);
+        }
+    }
+
+    static void read(FastVector::ByteReader& reader, value_type& value) {
+        auto present = reader.read<std::uint8_t>();
+        if (present > 1) {
+            throw std::runtime_error("Invalid optional presence flag");
+        }
+        if (present) {
+            element_codec::read(reader, value.emplace());
+        } else {
+            value.reset();
+        }
+    }
+};
+
+namespace detail
+{
+    // Maps: entry count, then key and value for each entry in iteration order
+    template<typename Map, IntegerEncoding Encoding>
+    struct MapCodec {
+        using key_codec = FieldCodec<typename Map::key_type, Encoding>;
+        using mapped_codec = FieldCodec<typename Map::mapped_type, Encoding>;
+        static constexpr bool is_fixed_size = false;
+        static constexpr std::size_t fixed_size = 0;
+
+        static std::size_t size(const Map& value) {
+            std::size_t total = length_prefix_size<Encoding>(value.size());
+            if constexpr (key_codec::is_fixed_size && mapped_codec::is_fixed_size) {
+                return total + value.size() * (key_codec::fixed_size + mapped_codec::fixed_size);
+            } else {
+                for (const auto& [key, mapped] : value) {
+                    total += key_codec::size(key) + mapped_codec::size(mapped);
+                }
+                return total;
+            }
+        }
+
+        static void write(FastVector::ByteWriter& writer, const Map& value) {
+            write_count<Encoding>(writer, value.size());
+            for (const auto& [key, mapped] : value) {
+                key_codec::write(writer, key);
+                mapped_codec::write(writer, mapped);
+            }
+        }
+
+        static void read(FastVector::ByteReader& reader, Map& value) {
+            std::size_t count = read_count<Encoding>(reader);
+            check_count<key_codec>(reader, count);
+            value.clear();
+            if constexpr (requires { value.reserve(count); }) {
+                value.reserve(count);
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                typename Map::key_type key{};
+                typename Map::mapped_type mapped{};
+                key_codec::read(reader, key);
+                mapped_codec::read(reader, mapped);
+                if (!value.emplace(std::move(key), std::move(mapped)).second) {
+                    throw std::runtime_error("Duplicate map key");
+                }
+            }
+        }
+    };
+}
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Allocator, IntegerEncoding Encoding>
+struct FieldCodec<std::unordered_map<K, V, Hash, KeyEqual, Allocator>, Encoding>
+        : detail::MapCodec<std::unordered_map<K, V, Hash, KeyEqual, Allocator>, Encoding> {};
+
+template<typename K, typename V, typename Compare, typename Allocator, IntegerEncoding Encoding>
+struct FieldCodec<std::map<K, V, Compare, Allocator>, Encoding>
+        : detail::MapCodec<std::map<K, V, Compare, Allocator>, Encoding> {};
+
+// The field type a generated View uses for a message field of type T
+template<typename T>
+struct view_field {
+    using type = T;
+};
+
+template<>
+struct view_field<std::string> {
+    using type = std::string_view;
+};
+
+template<std::size_t InlineN>
+struct view_field<FastVector::BasicByteVector<InlineN>> {
+    using type = FastVector::ByteSpan;
+};
+
+template<ReflectedMessage T>
+    requires requires { typename T::View; }
+struct view_field<T> {
+    using type = typename T::View;
+};
+
+template<typename T>
+using view_field_t = typename view_field<T>::type;
+
+template<typename T>
+inline constexpr bool is_container_field_v = false;
+
+template<typename T, typename Allocator>
+inline constexpr bool is_container_field_v<std::vector<T, Allocator>> = true;
+
+template<typename T, std::size_t N>
+inline constexpr bool is_container_field_v<std::array<T, N>> = true;
+
+template<typename T>
+inline constexpr bool is_container_field_v<std::optional<T>> = true;
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Allocator>
+inline constexpr bool is_container_field_v<std::unordered_map<K, V, Hash, KeyEqual, Allocator>> = true;
+
+template<typename K, typename V, typename Compare, typename Allocator>
+inline constexpr bool is_container_field_v<std::map<K, V, Compare, Allocator>> = true;
+
+// Encoder and decoder generated from a message's field list. Fixed-size fields are
+// summed at compile time; size() only walks the variable-size ones.
+template<typename T>
+struct MessageCodec {
+    static_assert(ReflectedMessage<T>, "T must declare its fields with SERVERKIT_MESSAGE");
+
+    static constexpr auto fields = serverkit_fields(static_cast<const T*>(nullptr));
+    static constexpr std::size_t field_count = std::tuple_size_v<decltype(fields)>;
+    static constexpr short type_id = T::MessageTypeId;
+    static constexpr IntegerEncoding encoding = integer_encoding_v<T>;
+
+private:
+    template<std::size_t I>
+    using field_type = std::remove_cvref_t<decltype(std::declval<const T&>().*std::get<I>(fields))>;
+
+    template<std::size_t I>
+    using field_codec = FieldCodec<field_type<I>, encoding>;
+
+    template<std::size_t... I>
+    static constexpr bool all_fixed(std::index_sequence<I...>) {
+        return (field_codec<I>::is_fixed_size && ...);
+    }
+
+    template<std::size_t... I>
+    static constexpr std::size_t sum_fixed(std::index_sequence<I...>) {
+        return (std::size_t{0} + ... + field_codec<I>::fixed_size);
+    }
+
+    template<std::size_t... I>
+    static std::size_t variable_size(const T& message, std::index_sequence<I...>) {
+        std::size_t total = 0;
+        ((total += field_codec<I>::is_fixed_size
+                   ? 0 : field_codec<I>::size(message.*std::get<I>(fields))), ...);
+        return total;
+    }
+
+    template<std::size_t... I>
+    static void write_fields(FastVector::ByteWriter& writer, const T& message, std::index_sequence<I...>) {
+        (field_codec<I>::write(writer, message.*std::get<I>(fields)), ...);
+    }
+
+    template<std::size_t... I>
+    static void read_fields(FastVector::ByteReader& reader, T& message, std::index_sequence<I...>) {
+        (field_codec<I>::read(reader, message.*std::get<I>(fields)), ...);
+    }
+
+    using indices = std::make_index_sequence<field_count>;
+
+public:
+    static constexpr bool is_fixed_size = all_fixed(indices{});
+    static constexpr std::size_t fixed_bytes = sum_fixed(indices{});  // Fixed-size fields only
+
+    static std::size_t size(const T& message) {
+        if constexpr (is_fixed_size) {
+            return fixed_bytes;
+        } else {
+            return fixed_bytes + variable_size(message, indices{});
+        }
+    }
+
+    static void write(FastVector::ByteWriter& writer, const T& message) {
+        if constexpr (PackedLayoutMessage<T>) {
+            PackedMessage<T>::write(writer, message);
+        } else {
+            write_fields(writer, message, indices{});
+        }
+    }
+
+    static void read(FastVector::ByteReader& reader, T& message) {
+        if constexpr (PackedLayoutMessage<T>) {
+            PackedMessage<T>::read(reader, message);
+        } else {
+            read_fields(reader, message, indices{});
+        }
+    }
+
+    // The field-by-field path, also taken by packed messages on big-endian hosts
+    static void write_each_field(FastVector::ByteWriter& writer, const T& message) {
+        write_fields(writer, message, indices{});
+    }
+
+    static void read_each_field(FastVector::ByteReader& reader, T& message) {
+        read_fields(reader, message, indices{});
+    }
+};
+
+namespace detail
+{
+    template<typename Field>
+    struct is_std_array : std::false_type {};
+
+    template<typename T, std::size_t N>
+    struct is_std_array<std::array<T, N>> : std::true_type {};
+
+    template<typename Field>
+    constexpr bool is_packable_field() {
+        if constexpr (std::is_same_v<Field, bool>) {
+            return false;  // Any byte but 0 or 1 would be an invalid bool after memcpy
+        } else if constexpr (is_std_array<Field>::value) {
+            return is_packable_field<typename Field::value_type>();
+        } else {
+            return std::is_arithmetic_v<Field> || std::is_enum_v<Field> || PackedLayoutMessage<Field>;
+        }
+    }
+
+    template<typename T, std::size_t... I>
+    consteval bool packable_fields(std::index_sequence<I...>) {
+        constexpr auto fields = MessageCodec<T>::fields;
+        return (is_packable_field<std::remove_cvref_t<decltype(std::declval<const T&>().*std::get<I>(fields))>>() && ...);
+    }
+
+    // Memory order has to match wire order for the struct bytes to be the encoding
+    template<typename T, std::size_t... I>
+    consteval bool fields_in_declaration_order(std::index_sequence<I...>) {
+        constexpr auto fields = MessageCodec<T>::fields;
+        T probe{};
+        const void* addresses[] = {static_cast<const void*>(&(probe.*std::get<I>(fields)))...};
+        for (std::size_t i = 1; i < sizeof...(I); ++i) {
+            if (!(addresses[i - 1] < addresses[i])) return false;
+        }
+        return true;
+    }
+}
+
+// Whole-struct codec for messages declared with SERVERKIT_PACKED_MESSAGE. The fields
+// must all be fixed-size scalars, enums, std::arrays of those or nested packed messages,
+// listed in declaration order, with no padding. The struct's bytes then equal its
+// little-endian field-wise encoding, so on little-endian hosts encode and decode are
+// one memcpy; big-endian hosts swap field by field. The wire format is the same either
+// way.
+template<typename T>
+struct PackedMessage {
+    static_assert(PackedLayoutMessage<T>, "T must be declared with SERVERKIT_PACKED_MESSAGE");
+    static_assert(std::is_trivially_copyable_v<T>, "packed messages must be trivially copyable");
+    static_assert(detail::packable_fields<T>(std::make_index_sequence<MessageCodec<T>::field_count>{}),
+                  "packed message fields must be arithmetic (not bool), enums, arrays or packed messages");
+    static_assert(integer_encoding_v<T> == IntegerEncoding::Fixed, "packed messages use fixed-width integers");
+    static_assert(MessageCodec<T>::fixed_bytes == sizeof(T),
+                  "packed message has padding or members missing from its field list");
+    static_assert(detail::fields_in_declaration_order<T>(std::make_index_sequence<MessageCodec<T>::field_count>{}),
+                  "packed message fields must be listed in declaration order");
+
+    static constexpr std::size_t size = sizeof(T);
+
+    static void write(FastVector::ByteWriter& writer, const T& message) {
+        if constexpr (std::endian::native == std::endian::little) {
+            writer.writeBytes(&message, sizeof(T));
+        } else {
+            MessageCodec<T>::write_each_field(writer, message);
+        }
+    }
+
+    static void read(FastVector::ByteReader& reader, T& message) {
+        if constexpr (std::endian::native == std::endian::little) {
+            FastVector::ByteSpan bytes = reader.readBytes(sizeof(T));
+            std::memcpy(&message, bytes.data(), sizeof(T));
+        } else {
+            MessageCodec<T>::read_each_field(reader, message);
+        }
+    }
+};
+
+template<ReflectedMessage T>
+inline constexpr short message_type_id_v = T::MessageTypeId;
+
+// Type ID followed by the fields, the layout BinaryMessage<T> produces
+template<ReflectedMessage T>
+FastVector::ByteVector serializeMessage(const T& message) {
+    FastVector::ByteVector data;
+    data.resize_uninitialized(sizeof(short) + MessageCodec<T>::size(message));
+    FastVector::ByteWriter writer(data.data(), data.size());
+    writer.write(message_type_id_v<T>);
+    MessageCodec<T>::write(writer, message);
+    return data;
+}
+
+// The full TCP frame, 4-byte size header included; send with Session::writeFrame()
+template<ReflectedMessage T>
+FastVector::ByteVector serializeMessageFrame(const T& message) {
+    std::size_t payload_size = sizeof(short) + MessageCodec<T>::size(message);
+    if (payload_size > FrameHeader::SIZE_MASK) {
+        throw std::runtime_error("Frame too large");
+    }
+    FastVector::ByteVector frame;
+    frame.resize_uninitialized(sizeof(std::uint32_t) + payload_size);
+    FastVector::ByteWriter writer(frame.data(), frame.size());
+    writer.write(static_cast<std::uint32_t>(payload_size));
+    writer.write(message_type_id_v<T>);
+    MessageCodec<T>::write(writer, message);
+    return frame;
+}
+
+// Decodes a message written by serializeMessage(); throws if the type ID does not match
+template<ReflectedMessage T>
+T deserializeMessage(FastVector::ByteSpan data) {
+    FastVector::ByteReader reader(data);
+    if (reader.read<short>() != message_type_id_v<T>) {
+        throw std::runtime_error("Message type does not match the expected schema");
+    }
+    T message{};
+    MessageCodec<T>::read(reader, message);
+    return message;
+}
+
+}
+
+// Argument-counting FOR_EACH used by SERVERKIT_MESSAGE; supports up to 16 fields. S
+// names a macro that expands to the separator between results. The extra
+// SERVERKIT_EXPAND passes keep MSVC's traditional preprocessor happy.
+#define SERVERKIT_EXPAND(x) x
+#define SERVERKIT_COMMA() ,
+#define SERVERKIT_NO_SEPARATOR()
+#define SERVERKIT_MEMBER_POINTER(Type, field) &Type::field
+#define SERVERKIT_VIEW_MEMBER(Type, field) ::NetworkMessages::view_field_t<decltype(Type::field)> field{};
+#define SERVERKIT_FE_1(M, S, T, x) M(T, x)
+#define SERVERKIT_FE_2(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_1(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_3(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_2(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_4(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_3(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_5(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_4(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_6(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_5(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_7(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_6(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_8(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_7(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_9(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_8(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_10(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_9(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_11(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_10(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_12(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_11(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_13(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_12(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_14(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_13(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_15(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_14(M, S, T, __VA_ARGS__))
+#define SERVERKIT_FE_16(M, S, T, x, ...) M(T, x) S() SERVERKIT_EXPAND(SERVERKIT_FE_15(M, S, T, __VA_ARGS__))
+#define SERVERKIT_GET_FE(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, NAME, ...) NAME
+#define SERVERKIT_FOR_EACH(M, S, T, ...) \
+    SERVERKIT_EXPAND(SERVERKIT_GET_FE(__VA_ARGS__, SERVERKIT_FE_16, SERVERKIT_FE_15, SERVERKIT_FE_14, \
+        SERVERKIT_FE_13, SERVERKIT_FE_12, SERVERKIT_FE_11, SERVERKIT_FE_10, SERVERKIT_FE_9, SERVERKIT_FE_8, \
+        SERVERKIT_FE_7, SERVERKIT_FE_6, SERVERKIT_FE_5, SERVERKIT_FE_4, SERVERKIT_FE_3, SERVERKIT_FE_2, \
+        SERVERKIT_FE_1)(M, S, T, __VA_ARGS__))
+
+// Declares Type's wire schema inside its definition: the message type ID, the fields
+// in wire order and the non-owning Type::View. Type stays an aggregate.
+#define SERVERKIT_MESSAGE(Type, TypeId, ...) \
+    static constexpr short MessageTypeId = TypeId; \
+    friend constexpr auto serverkit_fields(const Type*) { \
+        return std::make_tuple(SERVERKIT_FOR_EACH(SERVERKIT_MEMBER_POINTER, SERVERKIT_COMMA, Type, __VA_ARGS__)); \
+    } \
+    struct View { \
+        using ViewedMessage = Type; \
+        static constexpr short MessageTypeId = TypeId; \
+        SERVERKIT_FOR_EACH(SERVERKIT_VIEW_MEMBER, SERVERKIT_NO_SEPARATOR, Type, __VA_ARGS__) \
+        friend constexpr auto serverkit_fields(const View*) { \
+            return std::make_tuple(SERVERKIT_FOR_EACH(SERVERKIT_MEMBER_POINTER, SERVERKIT_COMMA, View, __VA_ARGS__)); \
+        } \
+    };
+
+// SERVERKIT_MESSAGE for fixed-layout structs that are encoded with one memcpy; see
+// PackedMessage for the layout rules, which are checked at compile time
+#define SERVERKIT_PACKED_MESSAGE(Type, TypeId, ...) \
+    SERVERKIT_MESSAGE(Type, TypeId, __VA_ARGS__) \
+    static constexpr bool PackedLayout = true;
+
+// Selects the integer encoding of the enclosing SERVERKIT_MESSAGE struct: Fixed or Varint
+#define SERVERKIT_INTEGER_ENCODING(Encoding) \
+    static constexpr ::NetworkMessages::IntegerEncoding MessageIntegerEncoding = \
+        ::NetworkMessages::IntegerEncoding::Encoding;
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
+
+
+namespace FastVector
+{
+
+namespace detail
+{
+
+// Storage and consumer side shared by the byte rings. Indices grow without bound and
+// are masked on access, so a full ring (write - read == capacity) and an empty one
+// (write == read) are told apart without wasting a slot.
+class ByteRingBase {
+public:
+    using size_type = std::size_t;
+
+    static constexpr size_type CACHE_LINE = 64;
+
+    explicit ByteRingBase(size_type min_capacity)
+            : capacity_(round_up_pow2(min_capacity)), mask_(capacity_ - 1),
+              storage_(std::make_unique<std::uint8_t[]>(capacity_)) {}
+
+    ByteRingBase(const ByteRingBase&) = delete;
+    ByteRingBase& operator=(const ByteRingBase&) = delete;
+
+    size_type capacity() const { return capacity_; }
+
+    // Bytes ready for the consumer; a snapshot when called from a producer
+    size_type size() const {
+        return write_index_.load(std::memory_order_acquire) - read_index_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // Consumer: the readable bytes up to the physical end of the storage. When the data
+    // wraps, a second call after commitRead() returns the rest.
+    std::span<const std::uint8_t> readableSpan() const {
+        size_type read = read_index_.load(std::memory_order_relaxed);
+        size_type available = write_index_.load(std::memory_order_acquire) - read;
+        size_type offset = read & mask_;
+        return {storage_.get() + offset, std::min(available, capacity_ - offset)};
+    }
+
+    // Consumer: releases n bytes previously returned by readableSpan()
+    void commitRead(size_type n) {
+        read_index_.store(read_index_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Consumer: copies up to n bytes out of the ring, handling wrap-around. Never blocks.
+    size_type read(void* destination, size_type n) {
+        size_type read = read_index_.load(std::memory_order_relaxed);
+        size_type count = std::min(n, write_index_.load(std::memory_order_acquire) - read);
+        copy_out(read, static_cast<std::uint8_t*>(destination), count);
+        read_index_.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+protected:
+    static size_type round_up_pow2(size_type n) {
+        if (n == 0) {
+            throw std::invalid_argument("ByteRing capacity must be greater than zero");
+        }
+        size_type capacity = 1;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    void copy_in(size_type position, const std::uint8_t* source, size_type n) {
+        size_type offset = position & mask_;
+        size_type first = std::min(n, capacity_ - offset);
+        std::memcpy(storage_.get() + offset, source, first);
+        if (n > first) {
+            std::memcpy(storage_.get(), source + first, n - first);
+        }
+    }
+
+    void copy_out(size_type position, std::uint8_t* destination, size_type n) const {
+        size_type offset = position & mask_;
+        size_type first = std::min(n, capacity_ - offset);
+        std::memcpy(destination, storage_.get() + offset, first);
+        if (n > first) {
+            std::memcpy(destination + first, storage_.get(), n - first);
+        }
+    }
+
+    const size_type capacity_;
+    const size_type mask_;
+    std::unique_ptr<std::uint8_t[]> storage_;
+
+    // Producer and consumer indices on separate cache lines to avoid false sharing
+    alignas(CACHE_LINE) std::atomic<size_type> write_index_{0};  // Published to the consumer
+    alignas(CACHE_LINE) std::atomic<size_type> read_index_{0};
+};
+
+}
+
+// Fixed-capacity single-producer/single-consumer byte ring. Capacity is rounded up to a
+// power of two. Both sides are wait-free: a full ring makes write() return short and an
+// empty one makes read() return zero, neither ever takes a lock or moves existing data,
+// so the ring is safe to use from a real-time audio callback.
+class SpscByteRing : public detail::ByteRingBase {
+public:
+    explicit SpscByteRing(size_type min_capacity) : ByteRingBase(min_capacity) {}
+
+    size_type freeSpace() const { return capacity_ - size(); }
+
+    // Producer: the writable space up to the physical end of the storage. Fill it, then
+    // publish with commitWrite(); call again for the part that wraps to the front.
+    std::span<std::uint8_t> writableSpan() {
+        size_type write = write_index_.load(std::memory_order_relaxed);
+        size_type space = capacity_ - (write - read_index_.load(std::memory_order_acquire));
+        size_type offset = write & mask_;
+        return {storage_.get() + offset, std::min(space, capacity_ - offset)};
+    }
+
+    // Producer: publishes n bytes written into writableSpan()
+    void commitWrite(size_type n) {
+        write_index_.store(write_index_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Producer: copies up to n bytes in, handling wrap-around; returns the number written
+    size_type write(const void* source, size_type n) {
+        size_type write = write_index_.load(std::memory_order_relaxed);
+        size_type count = std::min(n, capacity_ - (write - read_index_.load(std::memory_order_acquire)));
+        copy_in(write, static_cast<const std::uint8_t*>(source), count);
+        write_index_.store(write + count, std::memory_order_release);
+        return count;
+    }
+};
+
+// Fixed-capacity multi-producer/single-consumer byte ring. Producers claim space with a
+// CAS on a reservation index, copy their bytes, then publish in reservation order. A
+// producer that finishes copying before an earlier one briefly spins until the earlier
+// write is published; the consumer side is the same wait-free path as SpscByteRing.
+class MpscByteRing : public detail::ByteRingBase {
+public:
+    explicit MpscByteRing(size_type min_capacity) : ByteRingBase(min_capacity) {}
+
+    size_type freeSpace() const {
+        return capacity_ - (reserve_index_.load(std::memory_order_acquire) - read_index_.load(std::memory_order_acquire));
+    }
+
+    // Producer: writes all n bytes or, if they do not fit, nothing. Keeping writes whole
+    // means bytes from concurrent producers never interleave within one write.
+    bool write(const void* source, size_type n) {
+        if (n == 0) return true;
+        size_type start = reserve_index_.load(std::memory_order_relaxed);
+        do {
+            if (n > capacity_ - (start - read_index_.load(std::memory_order_acquire))) {
+                return false;
+            }
+        } while (!reserve_index_.compare_exchange_weak(start, start + n, std::memory_order_acq_rel,
+                                                       std::memory_order_relaxed));
+
+        copy_in(start, static_cast<const std::uint8_t*>(source), n);
+
+        // Publish in reservation order
+        while (write_index_.load(std::memory_order_acquire) != start) {
+            std::this_thread::yield();
+        }
+        write_index_.store(start + n, std::memory_order_release);
+        return true;
+    }
+
+private:
+    alignas(CACHE_LINE) std::atomic<size_type> reserve_index_{0};
+};
+
+
+}
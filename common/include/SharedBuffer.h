@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "ByteVector.h"
+
+
+namespace FastVector
+{
+
+// Immutable, atomically reference-counted byte buffer.
+//
+// A SharedBuffer takes ownership of a byte vector by moving it, after which the bytes
+// can no longer change; heap storage of the source vector is adopted without copying.
+// Copies only bump the reference count, so one serialized message can sit in any
+// number of write queues at once, e.g. when broadcasting to every session of a server.
+class SharedBuffer {
+public:
+    using value_type = std::uint8_t;
+    using size_type = std::size_t;
+    using const_reference = const value_type&;
+    using const_pointer = const value_type*;
+    using const_iterator = const_pointer;
+
+    SharedBuffer() = default;
+
+    template<std::size_t InlineN>
+    explicit SharedBuffer(BasicByteVector<InlineN>&& bytes)
+            : storage_(std::make_shared<const HeapByteVector>(std::move(bytes))) {}
+
+    template<std::size_t InlineN>
+    static SharedBuffer copyOf(const BasicByteVector<InlineN>& bytes) {
+        return SharedBuffer(HeapByteVector(bytes));
+    }
+
+    const_reference operator[](size_type index) const { return (*storage_)[index]; }
+
+    const_pointer data() const { return storage_ ? storage_->data() : nullptr; }
+    size_type size() const { return storage_ ? storage_->size() : 0; }
+    bool empty() const { return size() == 0; }
+
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size(); }
+
+    // Number of SharedBuffer instances currently sharing the bytes
+    long use_count() const { return storage_.use_count(); }
+
+private:
+    std::shared_ptr<const HeapByteVector> storage_;
+};
+
+
+}
@@ -45,6 +45,9 @@ public:
                                 [this](std::error_code ec, const std::shared_ptr<TCPNetworkUtility::Connection>& connection) {
                                     if (!ec) {
                                         m_session = TCPNetworkUtility::createSession(m_thread_pool->get_io_context(), connection->socket());
+                                        m_session->connection()->setBatching(m_batchOptions);
+                                        m_session->connection()->setCompression(m_compressionOptions);
+                                        m_session->connection()->setMaxFrameSize(m_maxFrameSize);
                                         m_connected.store(true);
                                         LOG_INFO("Connected to server");
                                         onConnected();
@@ -79,6 +82,24 @@ public:
         }
     }
 
+    // Sends a message serialized straight into its frame buffer
+    void sendMessage(const NetworkMessages::BinaryData& message) {
+        if (m_connected && m_session) {
+            m_session->writeFrame(message.serializeFrame());
+        } else {
+            LOG_ERROR("Cannot send message: not connected");
+        }
+    }
+
+    template<NetworkMessages::ReflectedMessage T>
+    void sendMessage(const T& message) {
+        if (m_connected && m_session) {
+            m_session->writeFrame(NetworkMessages::serializeMessageFrame(message));
+        } else {
+            LOG_ERROR("Cannot send message: not connected");
+        }
+    }
+
 protected:
     virtual void handleMessage(const FastVector::ByteVector& message) = 0;
 
@@ -101,6 +122,13 @@ protected:
         m_host = m_config.get<std::string>("server_host", "127.0.0.1");
         m_port = m_config.get<int>("server_port", 8080);
         int thread_count = m_config.get<int>("thread_count", 1);
+        m_batchOptions.enabled = m_config.get<bool>("batch_frames", false);
+        m_batchOptions.max_bytes = static_cast<std::size_t>(m_config.get<int>("batch_max_bytes", 16 * 1024));
+        m_batchOptions.max_delay = std::chrono::microseconds(m_config.get<int>("batch_max_delay_us", 200));
+        m_compressionOptions.enabled = m_config.get<bool>("compress_frames", false);
+        m_compressionOptions.min_bytes = static_cast<std::size_t>(m_config.get<int>("compress_min_bytes", 512));
+        m_maxFrameSize = static_cast<std::size_t>(m_config.get<int>("max_frame_bytes",
+                static_cast<int>(TCPNetworkUtility::Connection::DEFAULT_MAX_FRAME_SIZE)));
 
         auto log_level = m_config.get<std::string>("log_level", "INFO");
         auto log_file = m_config.get<std::string>("log_file", "server.log");
@@ -127,5 +155,8 @@ protected:
     std::shared_ptr<TCPNetworkUtility::Session> m_session;
     std::string m_host;
     int m_port{};
+    NetworkMessages::BatchOptions m_batchOptions;
+    NetworkMessages::CompressionOptions m_compressionOptions;
+    std::size_t m_maxFrameSize{};
     std::atomic<bool> m_connected;
 };
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <asio.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -10,15 +14,44 @@
 
 #include "Logger.h"
 #include "ByteVector.h"
+#include "SharedBuffer.h"
+#include "BufferChain.h"
+#include "FrameHeader.h"
+#include "BatchFrame.h"
+#include "FrameCompression.h"
 
 class TCPNetworkUtility {
 public:
     class Connection : public std::enable_shared_from_this<Connection> {
     public:
         using DisconnectCallback = std::function<void(const std::string&)>;
+        using ReadCallback = std::function<void(const FastVector::ByteVector&)>;
+        using ViewCallback = std::function<void(FastVector::ByteSpan)>;
+
+        // Write-side counters; each write is one async_write, usually one send syscall
+        struct WriteStats {
+            std::uint64_t messages = 0;
+            std::uint64_t writes = 0;
+            std::uint64_t batches = 0;
+            std::uint64_t compressed = 0;    // Frames sent compressed
+            std::uint64_t bytes_saved = 0;   // Payload bytes compression kept off the wire
+        };
+
+        // Which end opens the batching and compression handshake. A peer built before
+        // batch and compressed frames existed reads a hello as the header of a 1 or 2 GiB
+        // plain frame, so the accepting end only ever answers hellos: it never sends one
+        // to a client that has not sent its own.
+        enum class HelloRole {
+            Send,    // read() sends a hello for each enabled feature; for connecting ends
+            Answer   // A hello is sent in reply to the peer's; for accepting ends
+        };
+
+        // Largest payload accepted from the peer unless setMaxFrameSize() says otherwise
+        static constexpr std::size_t DEFAULT_MAX_FRAME_SIZE = 64 * 1024 * 1024;
 
         explicit Connection(asio::io_context& io_context, std::string identifier)
-                : socket_(io_context), strand_(asio::make_strand(io_context)), identifier_(std::move(identifier)) {}
+                : socket_(io_context), strand_(asio::make_strand(io_context)), batch_timer_(strand_),
+                  identifier_(std::move(identifier)) {}
 
 
         static std::shared_ptr<Connection> create(asio::io_context& io_context, std::string identifier) {
@@ -28,33 +61,89 @@ public:
         asio::ip::tcp::socket& socket() { return socket_; }
 
         void write(const FastVector::ByteVector& message) {
-            LOG_DEBUG("Connection::write called. Message size: %zu", message.size());
-
-            // Prepare the packet: 4-byte header (payload size) + payload
-            FastVector::ByteVector packet;
-            auto size = static_cast<uint32_t>(message.size());
-            packet.resize(4 + size);
-            packet[0] = size & 0xFF;
-            packet[1] = (size >> 8) & 0xFF;
-            packet[2] = (size >> 16) & 0xFF;
-            packet[3] = (size >> 24) & 0xFF;
-            std::memcpy(packet.begin() + 4, message.begin(), message.size());
-
-            asio::post(strand_, [this, packet]() mutable {
-                bool write_in_progress = !write_queue_.empty();
-                write_queue_.push_back(packet);
-                if (!write_in_progress) {
-                    do_write();
-                }
-            });
+            FastVector::BufferChain frame = frame_header(message.size());
+            frame.append(FastVector::HeapByteVector(message));
+            queue_frame(std::move(frame));
+        }
+
+        // Payloads that live on the heap are handed over without copying
+        void write(FastVector::ByteVector&& message) {
+            FastVector::BufferChain frame = frame_header(message.size());
+            frame.append(std::move(message));
+            queue_frame(std::move(frame));
+        }
+
+        // Queues a shared payload; it is referenced rather than copied, so one payload
+        // can be queued on any number of connections.
+        void write(FastVector::SharedBuffer message) {
+            FastVector::BufferChain frame = frame_header(message.size());
+            frame.append(std::move(message));
+            queue_frame(std::move(frame));
+        }
+
+        // Queues a buffer that already starts with its 4-byte size header, as built by
+        // BinaryData::serializeFrame(); it goes out as a single segment
+        void writeFrame(FastVector::ByteVector&& frame) {
+            FastVector::BufferChain chain;
+            chain.append(std::move(frame));
+            queue_frame(std::move(chain));
+        }
+
+        // Enables coalescing of outgoing messages into batch frames; call before read(),
+        // which sends the hello that lets the peer batch in turn. Only enable it on the
+        // connecting end when the peer is known to understand batch frames.
+        void setBatching(const NetworkMessages::BatchOptions& options) {
+            batch_options_ = options;
+        }
+
+        // True once the peer has announced it accepts batch frames
+        bool peerAcceptsBatches() const {
+            return peer_accepts_batches_.load(std::memory_order_acquire);
+        }
+
+        // Enables compression of outgoing frames; like setBatching(), call before read(),
+        // which advertises support to the peer, and never against an older peer
+        void setCompression(const NetworkMessages::CompressionOptions& options) {
+            compression_options_ = options;
+        }
+
+        // Defaults to HelloRole::Send; call before read()
+        void setHelloRole(HelloRole role) {
+            hello_role_ = role;
+        }
+
+        // Frames whose payload, or decompressed payload, is larger than this close the
+        // connection before anything is allocated for them; call before read()
+        void setMaxFrameSize(std::size_t max_size) {
+            max_frame_size_ = std::min<std::size_t>(max_size, NetworkMessages::FrameHeader::SIZE_MASK);
+            decompressor_.setMaxSize(max_frame_size_);
+        }
+
+        // True once the peer has announced it accepts compressed frames
+        bool peerAcceptsCompression() const {
+            return peer_accepts_compression_.load(std::memory_order_acquire);
+        }
+
+        WriteStats writeStats() const {
+            return {messages_written_.load(std::memory_order_relaxed),
+                    writes_.load(std::memory_order_relaxed),
+                    batches_written_.load(std::memory_order_relaxed),
+                    frames_compressed_.load(std::memory_order_relaxed),
+                    bytes_saved_.load(std::memory_order_relaxed)};
         }
 
-        void read(const std::function<void(const FastVector::ByteVector&)>& callback) {
+        // Calls callback once per received message. The messages of a batch frame are
+        // copied one after another into a reused buffer; use readViews() to avoid that.
+        void read(const ReadCallback& callback) {
             LOG_DEBUG("Connection::read called");
+            start_reading(std::make_shared<const ReadHandler>(ReadHandler{callback, {}}));
+        }
 
-            asio::post(strand_, [this, callback]() mutable {
-                do_read_header(callback);
-            });
+        // Like read(), but each message is a view into the received frame, so batched
+        // messages are not copied. The view is only valid during the callback.
+        void readViews(const ViewCallback& callback) {
+            LOG_DEBUG("Connection::readViews called");
+            start_reading(std::make_shared<const ReadHandler>(ReadHandler{{}, callback}));
         }
 
         asio::ip::tcp::endpoint remoteEndpoint() const {
@@ -99,9 +188,160 @@ public:
         }
 
     private:
+        static constexpr std::size_t FRAME_HEADER_SIZE = NetworkMessages::FrameHeader::SIZE;
+
+        // Set by read() or readViews(); exactly one of the two callbacks is non-empty
+        struct ReadHandler {
+            ReadCallback message;
+            ViewCallback view;
+        };
+        using ReadHandlerPtr = std::shared_ptr<const ReadHandler>;
+
+        void start_reading(ReadHandlerPtr handler) {
+            asio::post(strand_, [this, self = shared_from_this(), handler = std::move(handler)]() {
+                if (hello_role_ == HelloRole::Send && batch_options_.enabled) {
+                    push_write(header_frame(NetworkMessages::BatchFrame::header(0)));
+                }
+                if (hello_role_ == HelloRole::Send && compression_options_.enabled) {
+                    push_write(header_frame(NetworkMessages::CompressedFrame::FLAG));
+                }
+                do_read_header(handler);
+            });
+        }
+
+        // Starts a frame with its 4-byte little-endian size header. The payload is added
+        // as a separate segment and both go out in one gather write.
+        static FastVector::BufferChain frame_header(std::size_t payload_size) {
+            if (payload_size > NetworkMessages::FrameHeader::SIZE_MASK) {
+                throw std::runtime_error("Frame too large");
+            }
+            return header_frame(static_cast<uint32_t>(payload_size));
+        }
+
+        static FastVector::BufferChain header_frame(uint32_t value) {
+            std::array<uint8_t, FRAME_HEADER_SIZE> header = {
+                    static_cast<uint8_t>(value & 0xFF),
+                    static_cast<uint8_t>((value >> 8) & 0xFF),
+                    static_cast<uint8_t>((value >> 16) & 0xFF),
+                    static_cast<uint8_t>((value >> 24) & 0xFF)
+            };
+            FastVector::BufferChain frame;
+            frame.appendCopy(header.data(), header.size());
+            return frame;
+        }
+
+        void queue_frame(FastVector::BufferChain frame) {
+            LOG_DEBUG("Connection::write called. Message size: %zu", frame.size() - FRAME_HEADER_SIZE);
+            asio::post(strand_, [this, self = shared_from_this(), frame = std::move(frame)]() mutable {
+                messages_written_.fetch_add(1, std::memory_order_relaxed);
+                if (batch_options_.enabled && peer_accepts_batches_.load(std::memory_order_relaxed) &&
+                    frame.size() - FRAME_HEADER_SIZE <= batch_options_.max_bytes) {
+                    add_to_batch(frame);
+                    return;
+                }
+                // Keeps the order of messages that are too large to batch
+                flush_batch();
+                push_write(std::move(frame));
+            });
+        }
+
+        // Adds the frame's payload to the pending batch and schedules the flush. Length
+        // prefixes and owned payload bytes are gathered in batch_tail_; shared payloads are
+        // referenced, so a broadcast is still not copied per connection, at the cost of
+        // two more segments in the batch's gather write.
+        void add_to_batch(const FastVector::BufferChain& frame) {
+            NetworkMessages::BatchFrame::appendMessageHeader(batch_tail_, frame.size() - FRAME_HEADER_SIZE);
+            std::size_t skip = FRAME_HEADER_SIZE;
+            for (const auto& segment : frame) {
+                std::size_t offset = std::min(skip, segment.size());
+                skip -= offset;
+                const FastVector::SharedBuffer* shared = segment.shared();
+                if (shared && offset == 0) {
+                    batch_.append(std::move(batch_tail_));
+                    batch_tail_ = FastVector::HeapByteVector();
+                    batch_.append(*shared);
+                } else {
+                    batch_tail_.insert(batch_tail_.end(), segment.data() + offset, segment.data() + segment.size());
+                }
+            }
+
+            if (batch_.size() + batch_tail_.size() >= batch_options_.max_bytes) {
+                flush_batch();
+            } else if (!batch_flush_scheduled_) {
+                batch_flush_scheduled_ = true;
+                auto on_deadline = [this, self = shared_from_this()](std::error_code ec = {}) {
+                    batch_flush_scheduled_ = false;
+                    if (!ec) {
+                        flush_batch();
+                    }
+                };
+                if (batch_options_.max_delay.count() == 0) {
+                    asio::post(strand_, on_deadline);
+                } else {
+                    batch_timer_.expires_after(batch_options_.max_delay);
+                    batch_timer_.async_wait(asio::bind_executor(strand_, on_deadline));
+                }
+            }
+        }
+
+        // A flush before the deadline leaves the timer running; it then flushes whatever
+        // has been batched since, which is never later than that batch's own deadline
+        void flush_batch() {
+            if (batch_.empty() && batch_tail_.empty()) {
+                return;
+            }
+            batch_.append(std::move(batch_tail_));
+            batch_tail_ = FastVector::HeapByteVector();
+            FastVector::BufferChain frame = header_frame(NetworkMessages::BatchFrame::header(batch_.size()));
+            frame.append(std::move(batch_));
+            batches_written_.fetch_add(1, std::memory_order_relaxed);
+            push_write(std::move(frame));
+        }
+
+        void push_write(FastVector::BufferChain frame) {
+            if (compression_options_.enabled && frame.size() - FRAME_HEADER_SIZE >= compression_options_.min_bytes &&
+                peer_accepts_compression_.load(std::memory_order_relaxed)) {
+                compress_frame(frame);
+            }
+            bool write_in_progress = !write_queue_.empty();
+            write_queue_.push_back(std::move(frame));
+            if (!write_in_progress) {
+                do_write();
+            }
+        }
+
+        // Replaces the frame with its compressed form if that is smaller; the batch bit of
+        // the header is kept. Frames are compressed in the order they are written, which
+        // is the order the peer decompresses them in.
+        void compress_frame(FastVector::BufferChain& frame) {
+            std::size_t payload_size = frame.size() - FRAME_HEADER_SIZE;
+            const std::uint8_t* header = frame.begin()->data();
+            uint32_t flags = (static_cast<uint32_t>(header[3]) << 24) & NetworkMessages::BatchFrame::FLAG;
+
+            std::uint8_t* staged = compressor_.stage(payload_size);
+            std::size_t skip = FRAME_HEADER_SIZE;
+            for (const auto& segment : frame) {
+                std::size_t offset = std::min(skip, segment.size());
+                skip -= offset;
+                std::memcpy(staged, segment.data() + offset, segment.size() - offset);
+                staged += segment.size() - offset;
+            }
+
+            FastVector::HeapByteVector compressed;
+            if (!compressor_.compressStaged(compressed)) {
+                return;
+            }
+            frames_compressed_.fetch_add(1, std::memory_order_relaxed);
+            bytes_saved_.fetch_add(payload_size - compressed.size(), std::memory_order_relaxed);
+            frame = header_frame(flags | NetworkMessages::CompressedFrame::FLAG | static_cast<uint32_t>(compressed.size()));
+            frame.append(std::move(compressed));
+        }
+
         void do_write() {
-            auto packet = std::make_shared<FastVector::ByteVector>(write_queue_.front());
-            asio::async_write(socket_, asio::buffer(*packet),
+            writes_.fetch_add(1, std::memory_order_relaxed);
+            // The front entry stays in place until its write completes, which keeps
+            // the buffer view valid
+            asio::async_write(socket_, write_queue_.front().buffers(),
                               asio::bind_executor(strand_, [this, self = shared_from_this()](std::error_code ec, std::size_t length) {
                                   if (!ec) {
                                       LOG_DEBUG("Write completed. Length: %zu", length);
@@ -116,21 +356,45 @@ public:
                               }));
         }
 
-        void do_read_header(const std::function<void(const FastVector::ByteVector&)>& callback) {
-            auto header_buffer = std::make_shared<std::vector<uint8_t>>(4);
+        void do_read_header(const ReadHandlerPtr& handler) {
+            auto header_buffer = std::make_shared<FastVector::TinyByteVector>(4);
             asio::async_read(socket_, asio::buffer(*header_buffer),
-                             asio::bind_executor(strand_, [this, self = shared_from_this(), callback, header_buffer]
+                             asio::bind_executor(strand_, [this, self = shared_from_this(), handler, header_buffer]
                                      (std::error_code ec, std::size_t /*length*/) {
                                  if (!ec) {
-                                     uint32_t payload_size = (*header_buffer)[0] |
-                                                             ((*header_buffer)[1] << 8) |
-                                                             ((*header_buffer)[2] << 16) |
-                                                             ((*header_buffer)[3] << 24);
+                                     uint32_t header = (*header_buffer)[0] |
+                                                       ((*header_buffer)[1] << 8) |
+                                                       ((*header_buffer)[2] << 16) |
+                                                       ((*header_buffer)[3] << 24);
                                      /*LOG_DEBUG("Read header: %02x %02x %02x %02x",
                                                (*header_buffer)[0], (*header_buffer)[1],
                                                (*header_buffer)[2], (*header_buffer)[3]);
-                                     LOG_DEBUG("Interpreted payload size: %u", payload_size);*/
-                                     do_read_body(payload_size, callback);
+                                     LOG_DEBUG("Interpreted header: %u", header);*/
+                                     bool batched = NetworkMessages::BatchFrame::isBatch(header);
+                                     bool compressed = NetworkMessages::CompressedFrame::isCompressed(header);
+                                     uint32_t payload_size = NetworkMessages::FrameHeader::payloadSize(header);
+                                     if (payload_size == 0 && batched) {
+                                         LOG_DEBUG("Peer accepts batch frames");
+                                         if (hello_role_ == HelloRole::Answer && batch_options_.enabled &&
+                                             !peer_accepts_batches_.load(std::memory_order_relaxed)) {
+                                             push_write(header_frame(NetworkMessages::BatchFrame::header(0)));
+                                         }
+                                         peer_accepts_batches_.store(true, std::memory_order_release);
+                                         do_read_header(handler);
+                                     } else if (payload_size == 0 && compressed) {
+                                         LOG_DEBUG("Peer accepts compressed frames");
+                                         if (hello_role_ == HelloRole::Answer && compression_options_.enabled &&
+                                             !peer_accepts_compression_.load(std::memory_order_relaxed)) {
+                                             push_write(header_frame(NetworkMessages::CompressedFrame::FLAG));
+                                         }
+                                         peer_accepts_compression_.store(true, std::memory_order_release);
+                                         do_read_header(handler);
+                                     } else if (payload_size > max_frame_size_) {
+                                         LOG_ERROR("Frame of %u bytes exceeds the limit of %zu bytes", payload_size, max_frame_size_);
+                                         close();
+                                     } else {
+                                         do_read_body(payload_size, batched, compressed, handler);
+                                     }
                                  } else if (ec == asio::error::eof) {
                                      LOG_INFO("Connection closed by peer");
                                  } else {
@@ -140,26 +404,62 @@ public:
                              }));
         }
 
-        void do_read_body(uint32_t payload_size, const std::function<void(const FastVector::ByteVector&)>& callback) {
+        void do_read_body(uint32_t payload_size, bool batched, bool compressed, const ReadHandlerPtr& handler) {
             LOG_DEBUG("Connection::do_read_body called. Payload size: %u", payload_size);
-            auto read_buffer = std::make_shared<FastVector::ByteVector>(payload_size);
+            // The socket overwrites the whole buffer, so skip zero-filling it first
+            auto read_buffer = std::make_shared<FastVector::ByteVector>();
+            read_buffer->resize_uninitialized(payload_size);
             asio::async_read(socket_, asio::buffer(*read_buffer),
-                             asio::bind_executor(strand_, [this, self = shared_from_this(), read_buffer, callback, payload_size]
+                             asio::bind_executor(strand_, [this, self = shared_from_this(), read_buffer, handler, payload_size, batched, compressed]
                                      (std::error_code ec, std::size_t length) {
                                  if (!ec) {
                                      LOG_DEBUG("Read message size: %zu", length);
                                      if (length == payload_size) {
-                                         // Execute callback outside of strand to prevent potential deadlocks
-                                         asio::post([this, callback, read_buffer]() {
-                                             LOG_DEBUG("Executing read callback");
+                                         auto payload = read_buffer;
+                                         if (compressed) {
+                                             // Decompressed here, in arrival order, since the history spans frames
                                              try {
-                                                 callback(*read_buffer);
+                                                 payload = std::make_shared<FastVector::ByteVector>();
+                                                 decompressor_.decompress(*read_buffer, *payload);
                                              } catch (const std::exception& e) {
-                                                 LOG_ERROR("Exception in read callback: %s", e.what());
+                                                 LOG_ERROR("Malformed compressed frame: %s", e.what());
+                                                 close();
+                                                 return;
+                                             }
+                                         }
+                                         if (batched) {
+                                             try {
+                                                 NetworkMessages::BatchFrame::count(*payload);
+                                             } catch (const std::exception& e) {
+                                                 LOG_ERROR("Malformed batch frame: %s", e.what());
+                                                 close();
+                                                 return;
+                                             }
+                                         }
+                                         // Execute callback outside of strand to prevent potential deadlocks
+                                         asio::post([this, self, handler, payload, batched]() {
+                                             LOG_DEBUG("Executing read callback");
+                                             if (batched) {
+                                                 // One callback per message, in order; read() callbacks get
+                                                 // each message copied into a reused buffer
+                                                 FastVector::ByteVector message;
+                                                 NetworkMessages::BatchFrame::forEach(*payload, [&](FastVector::ByteSpan bytes) {
+                                                     if (handler->view) {
+                                                         invoke_read_callback(handler->view, bytes);
+                                                     } else {
+                                                         message.clear();
+                                                         message.insert(message.end(), bytes.begin(), bytes.end());
+                                                         invoke_read_callback(handler->message, message);
+                                                     }
+                                                 });
+                                             } else if (handler->view) {
+                                                 invoke_read_callback(handler->view, FastVector::ByteSpan(*payload));
+                                             } else {
+                                                 invoke_read_callback(handler->message, *payload);
                                              }
                                              // Only start reading the next header after the callback has completed
-                                             asio::post(strand_, [this, callback]() {
-                                                 do_read_header(callback);
+                                             asio::post(strand_, [this, self, handler]() {
+                                                 do_read_header(handler);
                                              });
                                          });
                                      } else {
@@ -173,9 +473,38 @@ public:
                              }));
         }
 
+        template<typename Callback, typename Message>
+        static void invoke_read_callback(const Callback& callback, const Message& message) {
+            try {
+                callback(message);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Exception in read callback: %s", e.what());
+            }
+        }
+
         asio::ip::tcp::socket socket_;
         asio::strand<asio::io_context::executor_type> strand_;
-        std::deque<FastVector::ByteVector> write_queue_;
+        std::deque<FastVector::BufferChain> write_queue_;
+        // Batching state is only touched on the strand, except the peer flag and counters
+        NetworkMessages::BatchOptions batch_options_;
+        FastVector::BufferChain batch_;
+        FastVector::HeapByteVector batch_tail_;  // Bytes batched since the last shared payload
+        asio::steady_timer batch_timer_;
+        bool batch_flush_scheduled_ = false;
+        std::atomic<bool> peer_accepts_batches_{false};
+        std::atomic<std::uint64_t> messages_written_{0};
+        std::atomic<std::uint64_t> writes_{0};
+        std::atomic<std::uint64_t> batches_written_{0};
+        // Compression state; the compressor is used on the write path and the
+        // decompressor on the read path, both on the strand
+        NetworkMessages::CompressionOptions compression_options_;
+        NetworkMessages::FrameCompressor compressor_;
+        NetworkMessages::FrameDecompressor decompressor_{DEFAULT_MAX_FRAME_SIZE};
+        std::atomic<bool> peer_accepts_compression_{false};
+        std::atomic<std::uint64_t> frames_compressed_{0};
+        std::atomic<std::uint64_t> bytes_saved_{0};
+        HelloRole hello_role_ = HelloRole::Send;
+        std::size_t max_frame_size_ = DEFAULT_MAX_FRAME_SIZE;
         std::string identifier_;
         DisconnectCallback onDisconnected_;
     };
@@ -194,14 +523,30 @@ public:
         }
 
         void write(const FastVector::ByteVector& message) {
+            write(FastVector::SharedBuffer::copyOf(message));
+        }
+
+        void write(FastVector::ByteVector&& message) {
+            write(FastVector::SharedBuffer(std::move(message)));
+        }
+
+        void write(FastVector::SharedBuffer message) {
+            if (connection_) {
+                connection_->write(std::move(message));
+            } else {
+                LOG_ERROR("Attempting to write to null connection");
+            }
+        }
+
+        void writeFrame(FastVector::ByteVector&& frame) {
             if (connection_) {
-                connection_->write(message);
+                connection_->writeFrame(std::move(frame));
             } else {
                 LOG_ERROR("Attempting to write to null connection");
             }
         }
 
-        std::string getConnectionId()
+        const std::string& getConnectionId() const
         {
             return connection_id;
         }
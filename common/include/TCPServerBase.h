@@ -7,6 +7,7 @@
 #include "AsioThreadPool.h"
 #include "BinaryData.h"
 #include "Config.h"
+#include "MemoryPoolMonitor.h"
 #include "Logger.h"
 #include "TCPNetworkUtility.h"
 
@@ -40,11 +41,15 @@ public:
 
         LOG_INFO("Starting server on %s:%d", m_host.c_str(), m_port);
         startAccept();
+        m_memoryPoolMonitor->start();
         m_thread_pool->run();
     }
 
     void stop() {
         LOG_INFO("Stopping server");
+        if (m_memoryPoolMonitor) {
+            m_memoryPoolMonitor->stop();
+        }
         m_acceptor->close();
         if (m_thread_pool) {
             m_thread_pool->stop();
@@ -64,6 +69,11 @@ protected:
     }
 
     void broadcastMessage(const FastVector::ByteVector& message) {
+        broadcastMessage(FastVector::SharedBuffer::copyOf(message));
+    }
+
+    // Every session's write queue shares the same payload bytes
+    void broadcastMessage(const FastVector::SharedBuffer& message) {
         for (const auto& pair : m_sessions) {
             pair.second->write(message);
         }
@@ -76,6 +86,13 @@ private:
         m_host = m_config.get<std::string>("server_host", "127.0.0.1");
         m_port = m_config.get<int>("server_port", 8080);
         int thread_count = m_config.get<int>("thread_count", 0);
+        m_batchOptions.enabled = m_config.get<bool>("batch_frames", false);
+        m_batchOptions.max_bytes = static_cast<std::size_t>(m_config.get<int>("batch_max_bytes", 16 * 1024));
+        m_batchOptions.max_delay = std::chrono::microseconds(m_config.get<int>("batch_max_delay_us", 200));
+        m_compressionOptions.enabled = m_config.get<bool>("compress_frames", false);
+        m_compressionOptions.min_bytes = static_cast<std::size_t>(m_config.get<int>("compress_min_bytes", 512));
+        m_maxFrameSize = static_cast<std::size_t>(m_config.get<int>("max_frame_bytes",
+                static_cast<int>(TCPNetworkUtility::Connection::DEFAULT_MAX_FRAME_SIZE)));
 
         auto log_level = m_config.get<std::string>("log_level", "INFO");
         auto log_file = m_config.get<std::string>("log_file", "server.log");
@@ -94,6 +111,7 @@ private:
         m_acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true));
         m_acceptor->bind(endpoint);
         m_acceptor->listen();
+        m_memoryPoolMonitor = std::make_unique<MemoryPoolMonitor>(m_thread_pool->get_io_context(), m_config);
     }
 
     void startAccept() {
@@ -102,6 +120,10 @@ private:
                     if (!ec) {
                         auto session = TCPNetworkUtility::createSession(m_thread_pool->get_io_context(), socket);
                         m_sessions[session->getConnectionId()] = session;
+                        session->connection()->setBatching(m_batchOptions);
+                        session->connection()->setCompression(m_compressionOptions);
+                        session->connection()->setHelloRole(TCPNetworkUtility::Connection::HelloRole::Answer);
+                        session->connection()->setMaxFrameSize(m_maxFrameSize);
 
                         onClientConnected(session);
 
@@ -119,7 +141,11 @@ private:
     Config m_config;
     std::unique_ptr<AsioThreadPool> m_thread_pool;
     std::unique_ptr<asio::ip::tcp::acceptor> m_acceptor;
+    std::unique_ptr<MemoryPoolMonitor> m_memoryPoolMonitor;
     std::string m_host;
     int m_port{};
+    NetworkMessages::BatchOptions m_batchOptions;
+    NetworkMessages::CompressionOptions m_compressionOptions;
+    std::size_t m_maxFrameSize{};
     std::unordered_map<std::string, std::shared_ptr<TCPNetworkUtility::Session>> m_sessions;
 };
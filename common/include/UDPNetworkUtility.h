@@ -41,13 +41,14 @@ public:
 
     static void receiveFrom(std::shared_ptr<Endpoint> receiver, 
                             std::function<void(const asio::ip::udp::endpoint&, const FastVector::ByteVector&)> callback) {
-        auto buffer = std::make_shared<FastVector::ByteVector>(512); // Max UDP packet size
+        auto buffer = std::make_shared<FastVector::ByteVector>();
+        auto window = buffer->append_uninitialized(512); // Max UDP packet size
         auto sender_endpoint = std::make_shared<asio::ip::udp::endpoint>();
 
-        receiver->socket().async_receive_from(asio::buffer(*buffer), *sender_endpoint,
+        receiver->socket().async_receive_from(asio::buffer(window.data(), window.size()), *sender_endpoint,
             [receiver, buffer, sender_endpoint, callback](std::error_code ec, std::size_t bytes_recvd) {
                 if (!ec) {
-                    buffer->resize(bytes_recvd);
+                    buffer->commit(bytes_recvd);
                     callback(*sender_endpoint, *buffer);
                     receiveFrom(receiver, callback); // Continue receiving
                 } else {
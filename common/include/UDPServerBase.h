@@ -3,6 +3,7 @@
 #include "AsioThreadPool.h"
 #include "BinaryData.h"
 #include "Config.h"
+#include "MemoryPoolMonitor.h"
 #include "Logger.h"
 #include "UDPNetworkUtility.h"
 
@@ -36,11 +37,15 @@ public:
 
         //LOG_INFO("Starting UDP server on %s:%d", m_host.c_str(), m_port);
         startReceive();
+        m_memoryPoolMonitor->start();
         m_thread_pool->run();
     }
 
     void stop() {
         LOG_INFO("Stopping UDP server");
+        if (m_memoryPoolMonitor) {
+            m_memoryPoolMonitor->stop();
+        }
         if (m_endpoint) {
             m_endpoint->socket().close();
         }
@@ -76,6 +81,7 @@ private:
         m_thread_pool = std::make_unique<AsioThreadPool>(thread_count);
 
         m_endpoint = UDPNetworkUtility::createEndpoint(m_thread_pool->get_io_context(), m_host, m_port);
+        m_memoryPoolMonitor = std::make_unique<MemoryPoolMonitor>(m_thread_pool->get_io_context(), m_config);
     }
 
     void startReceive() {
@@ -88,6 +94,7 @@ private:
     Config m_config;
     std::unique_ptr<AsioThreadPool> m_thread_pool;
     std::shared_ptr<UDPNetworkUtility::Endpoint> m_endpoint;
+    std::unique_ptr<MemoryPoolMonitor> m_memoryPoolMonitor;
     std::string m_host;
     int m_port{};
 };
\ No newline at end of file
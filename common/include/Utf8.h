@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FASTVECTOR_UTF8_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FASTVECTOR_UTF8_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define FASTVECTOR_UTF8_NEON 1
+#endif
+
+
+namespace FastVector
+{
+
+namespace detail
+{
+
+constexpr std::size_t UTF8_BLOCK = 32;
+
+inline std::atomic<bool> validate_received_utf8{true};
+
+// True if none of the 32 bytes at p has its high bit set
+inline bool is_ascii_block(const std::uint8_t* p) {
+#if defined(FASTVECTOR_UTF8_AVX2)
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    return _mm256_movemask_epi8(block) == 0;
+#elif defined(FASTVECTOR_UTF8_SSE2)
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    return _mm_movemask_epi8(_mm_or_si128(low, high)) == 0;
+#elif defined(FASTVECTOR_UTF8_NEON)
+    uint8x16_t block = vorrq_u8(vld1q_u8(p), vld1q_u8(p + 16));
+    return vmaxvq_u8(block) < 0x80;
+#else
+    std::uint64_t words[4];
+    std::memcpy(words, p, sizeof(words));
+    return ((words[0] | words[1] | words[2] | words[3]) & 0x8080808080808080ULL) == 0;
+#endif
+}
+
+// Validates the sequence starting at data[i] and returns its length, or 0 if it is
+// malformed: overlong forms, surrogates and code points above U+10FFFF are rejected
+inline std::size_t utf8_sequence_length(const std::uint8_t* data, std::size_t i, std::size_t size) {
+    std::uint8_t lead = data[i];
+    if (lead < 0x80) return 1;
+
+    std::size_t length;
+    std::uint8_t second_min = 0x80;
+    std::uint8_t second_max = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) second_min = 0xA0;       // Overlong
+        else if (lead == 0xED) second_max = 0x9F;  // Surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) second_min = 0x90;       // Overlong
+        else if (lead == 0xF4) second_max = 0x8F;  // Above U+10FFFF
+    } else {
+        return 0;
+    }
+
+    if (size - i < length) return 0;
+    if (data[i + 1] < second_min || data[i + 1] > second_max) return 0;
+    for (std::size_t k = 2; k < length; ++k) {
+        if ((data[i + k] & 0xC0) != 0x80) return 0;
+    }
+    return length;
+}
+
+// Byte-at-a-time reference validator
+inline bool validate_utf8_scalar(const std::uint8_t* data, std::size_t size) {
+    std::size_t i = 0;
+    while (i < size) {
+        std::size_t length = utf8_sequence_length(data, i, size);
+        if (length == 0) return false;
+        i += length;
+    }
+    return true;
+}
+
+}
+
+// Checks that data is well-formed UTF-8. ASCII is skipped 32 bytes at a time with
+// AVX2, SSE2 or NEON (or 64-bit words where none is available), so ASCII-heavy text
+// validates at close to memory bandwidth; blocks containing multi-byte sequences fall
+// back to the scalar checker until the next block boundary.
+inline bool is_valid_utf8(const void* bytes, std::size_t size) {
+    const auto* data = static_cast<const std::uint8_t*>(bytes);
+    std::size_t i = 0;
+    while (i < size) {
+        if (size - i >= detail::UTF8_BLOCK && detail::is_ascii_block(data + i)) {
+            i += detail::UTF8_BLOCK;
+            continue;
+        }
+        // A sequence may run past stop; the next block check starts after it
+        std::size_t stop = std::min(size, i + detail::UTF8_BLOCK);
+        while (i < stop) {
+            std::size_t length = detail::utf8_sequence_length(data, i, size);
+            if (length == 0) return false;
+            i += length;
+        }
+    }
+    return true;
+}
+
+inline bool is_valid_utf8(std::string_view text) {
+    return is_valid_utf8(text.data(), text.size());
+}
+
+// Whether decoders check received strings with is_valid_utf8(); on by default. Turn it
+// off when every peer is trusted.
+inline void set_utf8_validation(bool enabled) {
+    detail::validate_received_utf8.store(enabled, std::memory_order_relaxed);
+}
+
+inline bool utf8_validation_enabled() {
+    return detail::validate_received_utf8.load(std::memory_order_relaxed);
+}
+
+
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "ByteSpan.h"
+#include "ByteWriter.h"
+
+
+namespace FastVector
+{
+
+// LEB128 varints: 7 value bits per byte, least significant group first, high bit set on
+// every byte but the last. Values below 128 take one byte, a full uint64 takes ten.
+constexpr std::size_t MAX_VARINT_BYTES = 10;
+
+// Zigzag maps signed values onto unsigned ones so small magnitudes of either sign stay short
+constexpr std::uint64_t zigzag_encode(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+constexpr std::int64_t zigzag_decode(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+constexpr std::size_t varint_size(std::uint64_t value) {
+    return (static_cast<std::size_t>(std::bit_width(value | 1)) + 6) / 7;
+}
+
+// Writes value at out, which needs varint_size(value) bytes; returns the bytes written
+inline std::size_t encode_varint(std::uint64_t value, std::uint8_t* out) {
+    std::size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<std::uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = static_cast<std::uint8_t>(value);
+    return n;
+}
+
+namespace detail
+{
+    inline std::size_t decode_varint_slow(const std::uint8_t* data, std::size_t size, std::uint64_t& value) {
+        std::uint64_t result = 0;
+        std::size_t limit = size < MAX_VARINT_BYTES ? size : MAX_VARINT_BYTES;
+        for (std::size_t i = 0; i < limit; ++i) {
+            std::uint64_t group = data[i] & 0x7F;
+            if (i == MAX_VARINT_BYTES - 1 && group > 1) return 0;  // Over 64 bits
+            result |= group << (7 * i);
+            if ((data[i] & 0x80) == 0) {
+                value = result;
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+}
+
+// Decodes one varint from at most size bytes. Returns the bytes consumed, or 0 if the
+// input is truncated or longer than 64 bits. One- and two-byte values, the bulk of
+// counts, lengths and deltas, take a predictable branch each, which lets the CPU run
+// ahead to the next value. Longer ones, with 8 readable bytes and at most 56 value bits,
+// decode without a loop: the end is found with one count-trailing-zeros and the 7-bit
+// groups are packed together with three shift-and-mask steps.
+inline std::size_t decode_varint(const std::uint8_t* data, std::size_t size, std::uint64_t& value) {
+    if (size >= 2) {
+        if (data[0] < 0x80) {
+            value = data[0];
+            return 1;
+        }
+        if (data[1] < 0x80) {
+            value = (data[0] & 0x7FU) | (static_cast<std::uint64_t>(data[1]) << 7);
+            return 2;
+        }
+    }
+    if (size >= 8) {
+        std::uint64_t word = load_little_endian<std::uint64_t>(data);
+        std::uint64_t stop_bits = ~word & 0x8080808080808080ULL;
+        if (stop_bits != 0) {
+            std::size_t length = (static_cast<std::size_t>(std::countr_zero(stop_bits)) >> 3) + 1;
+            std::uint64_t x = length == 8 ? word : word & ((std::uint64_t{1} << (8 * length)) - 1);
+            x = ((x & 0x7F007F007F007F00ULL) >> 1) | (x & 0x007F007F007F007FULL);
+            x = ((x & 0x3FFF00003FFF0000ULL) >> 2) | (x & 0x00003FFF00003FFFULL);
+            x = ((x & 0x0FFFFFFF00000000ULL) >> 4) | (x & 0x000000000FFFFFFFULL);
+            value = x;
+            return length;
+        }
+    }
+    return detail::decode_varint_slow(data, size, value);
+}
+
+// Decodes count consecutive varints into out and returns the bytes consumed. Runs of
+// eight single-byte values, the common case for small counts and deltas, are copied
+// out eight at a time. Throws std::runtime_error on malformed or truncated input.
+inline std::size_t decode_varints(const std::uint8_t* data, std::size_t size, std::uint64_t* out, std::size_t count) {
+    std::size_t position = 0;
+    std::size_t i = 0;
+    while (i < count) {
+        if (count - i >= 8 && size - position >= 8) {
+            std::uint64_t word = load_little_endian<std::uint64_t>(data + position);
+            if ((word & 0x8080808080808080ULL) == 0) {
+                for (std::size_t k = 0; k < 8; ++k) {
+                    out[i + k] = (word >> (8 * k)) & 0xFF;
+                }
+                i += 8;
+                position += 8;
+                continue;
+            }
+        }
+        std::size_t consumed = decode_varint(data + position, size - position, out[i]);
+        if (consumed == 0) {
+            throw std::runtime_error("Invalid or truncated varint");
+        }
+        position += consumed;
+        ++i;
+    }
+    return position;
+}
+
+// Integer <-> varint with zigzag for signed types and a range check on decode
+template<typename T>
+constexpr std::uint64_t to_varint_bits(T value) {
+    static_assert(std::is_integral_v<T>, "varints hold integers");
+    if constexpr (std::is_signed_v<T>) {
+        return zigzag_encode(static_cast<std::int64_t>(value));
+    } else {
+        return static_cast<std::uint64_t>(value);
+    }
+}
+
+template<typename T>
+T from_varint_bits(std::uint64_t bits) {
+    static_assert(std::is_integral_v<T>, "varints hold integers");
+    if constexpr (std::is_signed_v<T>) {
+        std::int64_t value = zigzag_decode(bits);
+        if (value < static_cast<std::int64_t>(std::numeric_limits<T>::min()) ||
+            value > static_cast<std::int64_t>(std::numeric_limits<T>::max())) {
+            throw std::runtime_error("Varint out of range for the target type");
+        }
+        return static_cast<T>(value);
+    } else {
+        if (bits > static_cast<std::uint64_t>(std::numeric_limits<T>::max())) {
+            throw std::runtime_error("Varint out of range for the target type");
+        }
+        return static_cast<T>(bits);
+    }
+}
+
+inline void write_varint(ByteWriter& writer, std::uint64_t value) {
+    encode_varint(value, writer.skip(varint_size(value)));
+}
+
+inline std::uint64_t read_varint(ByteReader& reader) {
+    std::uint64_t value = 0;
+    std::size_t consumed = decode_varint(reader.data().data() + reader.position(), reader.remaining(), value);
+    if (consumed == 0) {
+        throw std::runtime_error("Invalid or truncated varint");
+    }
+    reader.skip(consumed);
+    return value;
+}
+
+// Reads count varints into integers of type T through decode_varints(), in chunks
+template<typename T>
+void read_varints(ByteReader& reader, T* out, std::size_t count) {
+    std::uint64_t bits[64];
+    for (std::size_t done = 0; done < count; done += 64) {
+        std::size_t chunk = count - done < 64 ? count - done : 64;
+        std::size_t position = reader.position();
+        reader.skip(decode_varints(reader.data().data() + position, reader.remaining(), bits, chunk));
+        for (std::size_t i = 0; i < chunk; ++i) {
+            out[done + i] = from_varint_bits<T>(bits[i]);
+        }
+    }
+}
+
+
+}
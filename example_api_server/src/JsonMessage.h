@@ -23,15 +23,14 @@ class JsonMessage : public NetworkMessages::BinaryData {
 public:
     json json_data;
 
-    std::vector<byte> serialize() override {
+    [[nodiscard]] ByteVector serialize() const override {
         std::string json_str = json_data.dump();
-        std::vector<byte> result;
+        ByteVector result;
         NetworkMessages::BinaryData::append_bytes(result, json_str);
         return result;
     }
 
-    void deserialize(const std::vector<byte>& data) override {
-        size_t offset = 0;
+    void deserialize(FastVector::ByteSpan data, size_t& offset) override {
         auto json_str = NetworkMessages::BinaryData::read_bytes<std::string>(data, offset);
         this->json_data = json::parse(json_str);
     }
@@ -9,14 +9,14 @@
 #pragma once
 
 #include "UDPClientBase.h"
+#include "RingBuffer.h"
 #include <portaudio.h>
-#include <vector>
-#include <mutex>
+#include <cstring>
 
 class AudioUDPClient : public UDPClientBase {
 public:
     explicit AudioUDPClient(const std::string& config_file)
-        : UDPClientBase(config_file), stream_(nullptr) {}
+        : UDPClientBase(config_file), stream_(nullptr), audioBuffer_(AUDIO_BUFFER_SIZE) {}
 
     ~AudioUDPClient() override {
         if (stream_) {
@@ -40,9 +40,11 @@ public:
     }
 
 protected:
+    // May run on any of the client's io threads; a packet that does not fit is dropped
     void handleMessage(const asio::ip::udp::endpoint& /*sender*/, const FastVector::ByteVector& message) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        audioBuffer_.insert(audioBuffer_.end(), message.begin(), message.end());
+        if (!audioBuffer_.write(message.data(), message.size())) {
+            LOG_WARNING("Audio buffer full, dropping %zu bytes", message.size());
+        }
     }
 
 private:
@@ -80,20 +82,19 @@ private:
         AudioUDPClient* client = static_cast<AudioUDPClient*>(userData);
         int16_t* out = static_cast<int16_t*>(outputBuffer);
 
-        std::lock_guard<std::mutex> lock(client->mutex_);
-        size_t bytesToCopy = std::min(static_cast<unsigned long>(client->audioBuffer_.size()), framesPerBuffer * 4);
-        if (bytesToCopy > 0) {
-            memcpy(out, client->audioBuffer_.data(), bytesToCopy);
-            client->audioBuffer_.erase(client->audioBuffer_.begin(), client->audioBuffer_.begin() + bytesToCopy);
-        } else {
-            memset(out, 0, framesPerBuffer * 4);
+        // Runs on the real-time audio thread: no locks and no moves, pad with silence on underrun
+        size_t bytesWanted = framesPerBuffer * 4;
+        size_t bytesCopied = client->audioBuffer_.read(out, bytesWanted);
+        if (bytesCopied < bytesWanted) {
+            memset(reinterpret_cast<uint8_t*>(out) + bytesCopied, 0, bytesWanted - bytesCopied);
         }
 
         return paContinue;
     }
 
+    static constexpr size_t AUDIO_BUFFER_SIZE = 256 * 1024;  // ~1.5 s of 16-bit stereo at 44.1 kHz
+
     PaStream* stream_;
-    FastVector::ByteVector audioBuffer_;
-    std::mutex mutex_;
+    FastVector::MpscByteRing audioBuffer_;
 };
 
@@ -7,15 +7,18 @@
 #include <vector>
 #include <asio.hpp>
 #include <portaudio.h>
-#include <queue>
-#include <mutex>
+#include <cstring>
 #include <thread>
 
+#include "RingBuffer.h"
+
 using asio::ip::udp;
 
 class AudioManager {
 public:
-    AudioManager() : input_stream_(nullptr), output_stream_(nullptr) {}
+    AudioManager()
+        : input_stream_(nullptr), output_stream_(nullptr),
+          input_buffer_(BUFFER_SIZE), output_buffer_(BUFFER_SIZE) {}
 
     bool initialize() {
         PaError err = Pa_Initialize();
@@ -63,15 +66,15 @@ public:
         return true;
     }
 
+    // Called from the network thread; bytes that do not fit are dropped
     void addOutputData(const char* data, size_t size) {
-        std::lock_guard<std::mutex> lock(output_mutex_);
-        output_buffer_.insert(output_buffer_.end(), data, data + size);
+        output_buffer_.write(data, size);
     }
 
+    // Called from the network thread; drains everything captured so far
     std::vector<char> getInputData() {
-        std::lock_guard<std::mutex> lock(input_mutex_);
-        std::vector<char> data = std::move(input_buffer_);
-        input_buffer_.clear();
+        std::vector<char> data(input_buffer_.size());
+        data.resize(input_buffer_.read(data.data(), data.size()));
         return data;
     }
 
@@ -96,10 +99,8 @@ private:
         AudioManager* manager = static_cast<AudioManager*>(userData);
         const int16_t* in = static_cast<const int16_t*>(inputBuffer);
 
-        std::lock_guard<std::mutex> lock(manager->input_mutex_);
-        manager->input_buffer_.insert(manager->input_buffer_.end(),
-                                      reinterpret_cast<const char*>(in),
-                                      reinterpret_cast<const char*>(in + framesPerBuffer));
+        // Real-time audio thread: never blocks; samples that do not fit are dropped
+        manager->input_buffer_.write(in, framesPerBuffer * sizeof(int16_t));
 
         return paContinue;
     }
@@ -112,24 +113,23 @@ private:
         AudioManager* manager = static_cast<AudioManager*>(userData);
         int16_t* out = static_cast<int16_t*>(outputBuffer);
 
-        std::lock_guard<std::mutex> lock(manager->output_mutex_);
-        size_t bytesToCopy = std::min(static_cast<unsigned long>(manager->output_buffer_.size()), framesPerBuffer * 2);
-        if (bytesToCopy > 0) {
-            memcpy(out, manager->output_buffer_.data(), bytesToCopy);
-            manager->output_buffer_.erase(manager->output_buffer_.begin(), manager->output_buffer_.begin() + bytesToCopy);
-        } else {
-            memset(out, 0, framesPerBuffer * 2);
+        // Real-time audio thread: never blocks, pads with silence on underrun
+        size_t bytesWanted = framesPerBuffer * sizeof(int16_t);
+        size_t bytesCopied = manager->output_buffer_.read(out, bytesWanted);
+        if (bytesCopied < bytesWanted) {
+            memset(reinterpret_cast<char*>(out) + bytesCopied, 0, bytesWanted - bytesCopied);
         }
 
         return paContinue;
     }
 
+    static constexpr size_t BUFFER_SIZE = 128 * 1024;  // ~1.5 s of 16-bit mono at 44.1 kHz
+
     PaStream* input_stream_;
     PaStream* output_stream_;
-    std::vector<char> input_buffer_;
-    std::vector<char> output_buffer_;
-    std::mutex input_mutex_;
-    std::mutex output_mutex_;
+    // Single producer and single consumer each: audio callback on one side, network thread on the other
+    FastVector::SpscByteRing input_buffer_;
+    FastVector::SpscByteRing output_buffer_;
 };
 
 class VoiceChatClient {
@@ -12,8 +12,8 @@ public:
             : TCPClientBase(config_file), m_username()
     {
         m_username = m_config.get<std::string>("user_name", "Unknown");
-        m_messageHandler.registerHandler(0, [this](const std::shared_ptr<TCPNetworkUtility::Session>& session, const FastVector::ByteVector& data) {
-            handleChatMessage(data);
+        m_messageHandler.registerViewHandler<NetworkMessages::ChatMessage>([this](const std::shared_ptr<TCPNetworkUtility::Session>& session, const NetworkMessages::ChatMessage::View& chatMessage) {
+            handleChatMessage(chatMessage);
         });
     }
 
@@ -56,25 +56,15 @@ protected:
     }
 
 private:
-    void handleChatMessage(const FastVector::ByteVector& data) {
-        LOG_DEBUG("handleMessage called. Data size: %zu", data.size());
-        try {
-            auto message = NetworkMessages::BinaryMessage<NetworkMessages::ChatMessage>(0, NetworkMessages::ChatMessage());
-            size_t offset = 0;
-            message.deserialize(data, offset);
-
-            const auto& chatMessage = message.getPayload();
-            std::cout << chatMessage.username << ": " << chatMessage.message << std::endl;
-            LOG_DEBUG("Message processed: %s: %s", chatMessage.username.c_str(), chatMessage.message.c_str());
-        } catch (const std::exception& e) {
-            LOG_ERROR("Error handling chat message: %s", e.what());
-        }
+    void handleChatMessage(const NetworkMessages::ChatMessage::View& chatMessage) {
+        std::cout << chatMessage.username << ": " << chatMessage.message << std::endl;
+        LOG_DEBUG("Message processed: %.*s: %.*s",
+                  static_cast<int>(chatMessage.username.size()), chatMessage.username.data(),
+                  static_cast<int>(chatMessage.message.size()), chatMessage.message.data());
     }
 
     void sendChatMessage(const std::string& message) {
-        NetworkMessages::ChatMessage chatMessage(m_username, message);
-        auto binaryMessage = NetworkMessages::MessageFactory::createMessage(0, chatMessage);
-        sendMessage(binaryMessage->serialize());
+        sendMessage(NetworkMessages::ChatMessage{m_username, message});
     }
 
     std::string m_username;
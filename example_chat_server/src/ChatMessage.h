@@ -4,33 +4,16 @@
 
 #pragma once
 
-#include "BinaryData.h"
+#include "MessageSchema.h"
 #include <string>
-#include <utility>
 
 namespace NetworkMessages {
 
-    class ChatMessage : public BinaryData {
-    public:
+    struct ChatMessage {
         std::string username;
         std::string message;
 
-        ChatMessage() = default;
-        ChatMessage(std::string username, std::string message)
-                : username(std::move(username)), message(std::move(message)) {}
-
-        [[nodiscard]] ByteVector serialize() const override {
-            ByteVector data;
-            append_bytes(data, username);
-            append_bytes(data, message);
-            return data;
-        }
-
-        void deserialize(const ByteVector& data, size_t& offset) override {
-            username = read_bytes<std::string>(data, offset);
-            message = read_bytes<std::string>(data, offset);
-        }
-
+        SERVERKIT_MESSAGE(ChatMessage, 0, username, message)
     };
 
 }  // namespace NetworkMessages
@@ -8,7 +8,7 @@
 class ChatServer : public TCPServerBase {
 public:
     explicit ChatServer(const std::string& config_file) : TCPServerBase(config_file) {
-        m_messageHandler.registerHandler(0, [this](const std::shared_ptr<TCPNetworkUtility::Session>& session, const FastVector::ByteVector& data) {
+        m_messageHandler.registerHandler(NetworkMessages::ChatMessage::MessageTypeId, [this](const std::shared_ptr<TCPNetworkUtility::Session>& session, const FastVector::ByteVector& data) {
             handleChatMessage(session, data);
         });
     }
@@ -21,15 +21,12 @@ protected:
 private:
     void handleChatMessage(const std::shared_ptr<TCPNetworkUtility::Session>& session, const FastVector::ByteVector& data) {
         try {
-            auto message = NetworkMessages::BinaryMessage<NetworkMessages::ChatMessage>(0, NetworkMessages::ChatMessage());
-            size_t offset = 0;
-            message.deserialize(data, offset);
-
-            const auto& chatMessage = message.getPayload();
-            LOG_INFO("Received message from %s (Session UUID: %s): %s",
-                     chatMessage.username.c_str(),
+            // Only logged and forwarded, so read it in place instead of copying the strings
+            auto chatMessage = NetworkMessages::deserializeMessage<NetworkMessages::ChatMessage::View>(data);
+            LOG_INFO("Received message from %.*s (Session UUID: %s): %.*s",
+                     static_cast<int>(chatMessage.username.size()), chatMessage.username.data(),
                      session->getConnectionId().c_str(),
-                     chatMessage.message.c_str());
+                     static_cast<int>(chatMessage.message.size()), chatMessage.message.data());
 
             // Broadcast the message to all clients
             broadcastMessage(data);
@@ -44,9 +41,8 @@ private:
         LOG_INFO("New client connected. Session UUID: %s", session->getConnectionId().c_str());
 
         // Send a welcome message to the new client
-        NetworkMessages::ChatMessage welcomeMessage("Server", "Welcome to the chat server!");
-        auto binaryMessage = NetworkMessages::MessageFactory::createMessage(0, welcomeMessage);
-        session->write(binaryMessage->serialize());
+        NetworkMessages::ChatMessage welcomeMessage{"Server", "Welcome to the chat server!"};
+        session->writeFrame(NetworkMessages::serializeMessageFrame(welcomeMessage));
     }
 
     void onClientDisconnected(const std::shared_ptr<TCPNetworkUtility::Session>& session) override {
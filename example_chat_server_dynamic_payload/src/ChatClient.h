@@ -3,6 +3,7 @@
 #include "TCPClientBase.h"
 #include "ChatMessage.h"
 #include "MessageHandler.h"
+#include "chat_messages.h"  // Generated from chat_messages.json
 #include <iostream>
 #include <thread>
 
@@ -12,9 +13,11 @@ public:
             : TCPClientBase(config_file), m_username()
     {
         m_username = m_config.get<std::string>("user_name", "Unknown");
-        MessageFactory::loadDefinitions("chat_messages.json");
-        m_messageHandler.registerHandler(0, [this](const std::shared_ptr<TCPNetworkUtility::Session>& session, const FastVector::ByteVector& data) {
-            handleChatMessage(data);
+        JSONPayload::MessageFactory::loadDefinitions("chat_messages.json");
+        m_usernameField = JSONPayload::MessageFactory::field("ChatMessage", "username");
+        m_messageField = JSONPayload::MessageFactory::field("ChatMessage", "message");
+        JSONPayload::registerPayloadHandler(m_messageHandler, JSONPayload::MessageFactory::typeOf("ChatMessage"), [this](const std::shared_ptr<TCPNetworkUtility::Session>& session, const JSONPayload::DynamicPayload& payload) {
+            handleChatMessage(payload);
         });
     }
 
@@ -57,25 +60,18 @@ protected:
     }
 
 private:
-    static void handleChatMessage(const FastVector::ByteVector& data) {
-        try {
-            auto message = MessageFactory::createMessage("ChatMessage");
-            message->deserialize(data);
-
-            const auto& payload = message->getPayload();
-            std::cout << payload.get<std::string>("username") << ": " << payload.get<std::string>("message") << std::endl;
-        } catch (const std::exception& e) {
-            LOG_ERROR("Error handling chat message: %s", e.what());
-        }
+    void handleChatMessage(const JSONPayload::DynamicPayload& payload) {
+        std::cout << payload.get<std::string>(m_usernameField) << ": " << payload.get<std::string>(m_messageField) << std::endl;
     }
 
+    // Sent through the struct generated from the same definitions the payloads are
+    // decoded with, so it is written straight into its frame
     void sendChatMessage(const std::string& message) {
-        auto chatMessage = MessageFactory::createMessage("ChatMessage");
-        chatMessage->getPayload().set("username", m_username);
-        chatMessage->getPayload().set("message", message);
-        sendMessage(chatMessage->serialize());
+        sendMessage(ChatSchema::ChatMessage{.message = message, .username = m_username});
     }
 
     std::string m_username;
     TCPMessageHandler m_messageHandler;
+    JSONPayload::FieldHandle m_usernameField;
+    JSONPayload::FieldHandle m_messageField;
 };
\ No newline at end of file
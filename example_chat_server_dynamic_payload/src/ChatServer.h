@@ -3,14 +3,18 @@
 #include "TCPServerBase.h"
 #include "ChatMessage.h"
 #include "MessageHandler.h"
+#include "chat_messages.h"  // Generated from chat_messages.json
 #include <iostream>
 
 class ChatServer : public TCPServerBase {
 public:
     explicit ChatServer(const std::string& config_file) : TCPServerBase(config_file) {
         JSONPayload::MessageFactory::loadDefinitions("chat_messages.json");
-        m_messageHandler.registerHandler(0, [this](const std::shared_ptr<TCPNetworkUtility::Session>& session, const FastVector::ByteVector& data) {
-            handleChatMessage(session, data);
+        m_usernameField = JSONPayload::MessageFactory::field("ChatMessage", "username");
+        m_messageField = JSONPayload::MessageFactory::field("ChatMessage", "message");
+        m_chatMessageType = JSONPayload::MessageFactory::typeOf("ChatMessage");
+        JSONPayload::registerPayloadHandler(m_messageHandler, m_chatMessageType, [this](const std::shared_ptr<TCPNetworkUtility::Session>& session, const JSONPayload::DynamicPayload& payload, const FastVector::ByteVector& data) {
+            handleChatMessage(session, payload, data);
         });
     }
 
@@ -20,44 +24,37 @@ protected:
     }
 
 private:
-    void handleChatMessage(const std::shared_ptr<TCPNetworkUtility::Session>& session, const FastVector::ByteVector& data) {
-        try {
-            auto message = JSONPayload::MessageFactory::createMessage("ChatMessage");
-            message->deserialize(data);
-
-            const auto& payload = message->getPayload();
-            LOG_INFO("Received message from %s (Session UUID: %s): %s",
-                     payload.get<std::string>("username").c_str(),
-                     session->getConnectionId().c_str(),
-                     payload.get<std::string>("message").c_str());
-
-            // Broadcast the message to all clients
-            broadcastMessage(data);
-        } catch (const std::exception& e) {
-            LOG_ERROR("Error handling chat message: %s", e.what());
-        }
+    void handleChatMessage(const std::shared_ptr<TCPNetworkUtility::Session>& session, const JSONPayload::DynamicPayload& payload, const FastVector::ByteVector& data) {
+        LOG_INFO("Received message from %s (Session UUID: %s): %s",
+                 payload.get<std::string>(m_usernameField).c_str(),
+                 session->getConnectionId().c_str(),
+                 payload.get<std::string>(m_messageField).c_str());
+
+        // Broadcast the received frame, copied once into a buffer every session shares
+        broadcastMessage(FastVector::SharedBuffer::copyOf(data));
     }
 
     void onClientConnected(const std::shared_ptr<TCPNetworkUtility::Session>& session) override {
         TCPServerBase::onClientConnected(session);
 
-        LOG_INFO("New client connected. Session UUID: %s", session->getConnectionUuid().c_str());
+        LOG_INFO("New client connected. Session UUID: %s", session->getConnectionId().c_str());
 
         // Send a welcome message to the new client
-        auto welcomeMessage = MessageFactory::createMessage("ChatMessage");
-        welcomeMessage->getPayload().set("username", "Server");
-        welcomeMessage->getPayload().set("message", "Welcome to the chat server!");
-        session->write(welcomeMessage->serialize());
+        ChatSchema::ChatMessage welcomeMessage{.message = "Welcome to the chat server!", .username = "Server"};
+        session->writeFrame(NetworkMessages::serializeMessageFrame(welcomeMessage));
     }
 
     void onClientDisconnected(const std::shared_ptr<TCPNetworkUtility::Session>& session) override {
         TCPServerBase::onClientDisconnected(session);
 
-        LOG_INFO("Client disconnected. Session UUID: %s", session->getConnectionUuid().c_str());
+        LOG_INFO("Client disconnected. Session UUID: %s", session->getConnectionId().c_str());
 
         // You could implement additional logic here, such as notifying other clients
         // that a user has left the chat.
     }
 
     TCPMessageHandler m_messageHandler;
+    JSONPayload::FieldHandle m_usernameField;
+    JSONPayload::FieldHandle m_messageField;
+    short m_chatMessageType{};
 };
\ No newline at end of file
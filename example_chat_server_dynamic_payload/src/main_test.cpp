@@ -2,11 +2,15 @@
 // Created by maxim on 24.08.2024.
 //
 #include <iostream>
+#include <iomanip>
 #include <chrono>
+#include <numeric>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 #include "DynamicPayload.h"
+#include "HeapAllocationCounter.h"
 
 class ChatMessage : public NetworkMessages::BinaryData {
 public:
@@ -17,6 +21,7 @@ public:
     ChatMessage(std::string username, std::string message)
             : username(std::move(username)), message(std::move(message)) {}
 
+    // Field-by-field append_bytes, kept as the baseline for the allocation report
     [[nodiscard]] ByteVector serialize() const override {
         ByteVector data;
         append_bytes(data, username);
@@ -24,8 +29,16 @@ public:
         return data;
     }
 
-    void deserialize(const ByteVector& data) override {
-        size_t offset = 0;
+    [[nodiscard]] size_t serializedSize() const override {
+        return byte_size(username) + byte_size(message);
+    }
+
+    void serializeInto(FastVector::ByteWriter& writer) const override {
+        write_bytes(writer, username);
+        write_bytes(writer, message);
+    }
+
+    void deserialize(FastVector::ByteSpan data, size_t& offset) override {
         username = read_bytes<std::string>(data, offset);
         message = read_bytes<std::string>(data, offset);
     }
@@ -77,7 +90,8 @@ double test_normal_payload(int num_messages) {
 
         deserialize_time += measure_time([&]() {
             NetworkMessages::BinaryMessage<ChatMessage> message(0, ChatMessage());
-            message.deserialize(serialized);
+            size_t offset = 0;
+            message.deserialize(serialized, offset);
         });
     }
 
@@ -94,17 +108,19 @@ double test_optimized_dynamic_payload(int num_messages) {
     double serialize_time = 0.0;
     double deserialize_time = 0.0;
     std::vector<FastVector::ByteVector> serialized_messages;
+    const auto username_field = JSONPayload::MessageFactory::field("ChatMessage", "username");
+    const auto message_field = JSONPayload::MessageFactory::field("ChatMessage", "message");
 
     for (int i = 0; i < num_messages; ++i) {
 
         serialize_time += measure_time([&]() {
             auto message = JSONPayload::MessageFactory::createMessage("ChatMessage");
-            auto& payload = message.getPayload();
+            auto& payload = message->getPayload();
             std::string username = generate_random_string(10);
             std::string random_message = generate_random_string(50);
-            payload.set(username);
-            payload.set(random_message);
-            serialized_messages.push_back(message.serialize());
+            payload.set(username_field, username);
+            payload.set(message_field, random_message);
+            serialized_messages.push_back(message->serialize());
         });
     }
 
@@ -112,7 +128,8 @@ double test_optimized_dynamic_payload(int num_messages) {
 
         deserialize_time += measure_time([&]() {
             auto message = JSONPayload::MessageFactory::createMessage("ChatMessage");
-            message.deserialize(serialized);
+            size_t offset = 0;
+            message->deserialize(serialized, offset);
         });
     }
 
@@ -124,6 +141,78 @@ double test_optimized_dynamic_payload(int num_messages) {
     return total_time;
 }
 
+// The frame as it was built before serializeInto(): type and payload serialized into
+// buffers of their own, concatenated, then copied again behind the length prefix
+FastVector::ByteVector build_frame_by_appending(short type, const ChatMessage& payload) {
+    FastVector::ByteVector typeData;
+    NetworkMessages::BinaryData::append_bytes(typeData, type);
+    auto payloadData = payload.serialize();
+    FastVector::ByteVector message;
+    message.insert(message.end(), typeData.begin(), typeData.end());
+    message.insert(message.end(), payloadData.begin(), payloadData.end());
+    FastVector::ByteVector frame;
+    NetworkMessages::BinaryData::append_bytes(frame, static_cast<uint32_t>(message.size()));
+    frame.insert(frame.end(), message.begin(), message.end());
+    return frame;
+}
+
+struct AllocationCount {
+    double heap;
+    double pool;
+};
+
+// Buffers beyond a ByteVector's inline capacity come from the MemoryPool rather than
+// operator new, so its allocation counter is sampled too. The work runs on its own thread:
+// the thread-local magazine publishes its counts when the thread exits.
+template<typename Func>
+AllocationCount count_allocations(int num_messages, Func&& func) {
+    auto pool_allocations = []() {
+        auto stats = FastVector::MemoryPool::getInstance().stats();
+        std::uint64_t total = stats.large_allocations;
+        for (const auto& class_stats : stats.classes) {
+            total += class_stats.allocations;
+        }
+        return total;
+    };
+
+    std::uint64_t pool_before = pool_allocations();
+    std::size_t heap_allocations = 0;
+    std::thread worker([&]() {
+        std::size_t heap_before = g_heap_allocations.load();
+        for (int i = 0; i < num_messages; ++i) {
+            func();
+        }
+        heap_allocations = g_heap_allocations.load() - heap_before;
+    });
+    worker.join();
+    std::uint64_t pool_after = pool_allocations();
+
+    return {static_cast<double>(heap_allocations) / num_messages,
+            static_cast<double>(pool_after - pool_before) / num_messages};
+}
+
+void report_allocations(int num_messages) {
+    std::cout << "Allocations per message (heap / MemoryPool):\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (int message_length : {50, 8000}) {
+        ChatMessage payload(generate_random_string(10), generate_random_string(message_length));
+        NetworkMessages::BinaryMessage<ChatMessage> message(0, payload);
+        FastVector::ByteVector sink;
+
+        auto appended = count_allocations(num_messages, [&]() {
+            sink = build_frame_by_appending(0, payload);
+        });
+        auto single_pass = count_allocations(num_messages, [&]() {
+            sink = message.serializeFrame();
+        });
+
+        std::cout << "  " << message_length << "-char message:\n";
+        std::cout << "    append_bytes + concatenation: " << appended.heap << " / " << appended.pool << "\n";
+        std::cout << "    serializeFrame:                " << single_pass.heap << " / " << single_pass.pool << "\n";
+    }
+    std::cout << std::defaultfloat << "\n";
+}
+
 int main() {
     JSONPayload::MessageFactory::loadDefinitions("chat_messages.json");
 
@@ -132,6 +221,8 @@ int main() {
 
     std::cout << "Testing with " << num_messages << " messages, " << num_runs << " runs each\n\n";
 
+    report_allocations(num_messages);
+
     // Warm-up run (not timed)
     test_normal_payload(1000);
     test_optimized_dynamic_payload(1000);
@@ -15,8 +15,7 @@ int main() {
         HTTPBody httpBody;
         httpBody.setContent(body);
         response.setBody(httpBody);
-        FastVector::ByteVector serializedBody = httpBody.serialize();
-        response.addHeader("Content-Length", std::to_string(serializedBody.size()));
+        response.addHeader("Content-Length", std::to_string(body.size()));
         return response;
     });
 
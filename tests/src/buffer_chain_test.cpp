@@ -0,0 +1,74 @@
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "BufferChain.h"
+#include "ByteVector.h"
+#include "SharedBuffer.h"
+
+// Builds a chain long enough to spill past the inline segments, one of them shared
+FastVector::BufferChain make_spilled_chain(const FastVector::SharedBuffer& shared) {
+    FastVector::BufferChain chain;
+    for (int i = 0; i < 6; ++i) {
+        chain.appendCopy("0123", 4);
+    }
+    chain.append(shared);
+    chain.append(std::string(100, 's'));
+    return chain;
+}
+
+bool holds_spilled_contents(const FastVector::BufferChain& chain, const char* what) {
+    if (chain.segmentCount() != 8 || chain.size() != 6 * 4 + 1000 + 100 || chain.flatten().size() != chain.size()) {
+        std::cout << "BufferChain " << what << " lost segments\n";
+        return false;
+    }
+    return true;
+}
+
+// A moved-from chain must be empty, not keep counts for segments it no longer holds,
+// and must have dropped its references to shared payloads.
+bool is_emptied(const FastVector::BufferChain& chain, const FastVector::SharedBuffer& shared, const char* what) {
+    if (chain.size() != 0 || chain.segmentCount() != 0 || chain.begin() != chain.end()) {
+        std::cout << "BufferChain " << what << " left the source non-empty\n";
+        return false;
+    }
+    if (shared.use_count() != 2) {
+        std::cout << "BufferChain " << what << " kept " << (shared.use_count() - 2) << " extra references to a shared payload\n";
+        return false;
+    }
+    return true;
+}
+
+bool move_leaves_source_empty() {
+    FastVector::SharedBuffer shared = FastVector::SharedBuffer::copyOf(FastVector::ByteVector(1000, std::uint8_t{0x5A}));
+    bool ok = true;
+
+    FastVector::BufferChain source = make_spilled_chain(shared);
+    FastVector::BufferChain moved(std::move(source));
+    ok &= holds_spilled_contents(moved, "move construction") && is_emptied(source, shared, "move construction");
+
+    FastVector::BufferChain assigned;
+    assigned.appendCopy("x", 1);
+    assigned = std::move(moved);
+    ok &= holds_spilled_contents(assigned, "move assignment") && is_emptied(moved, shared, "move assignment");
+
+    FastVector::BufferChain appended;
+    appended.append(std::move(assigned));
+    ok &= holds_spilled_contents(appended, "append") && is_emptied(assigned, shared, "append");
+
+    // A moved-from chain is reusable
+    assigned.appendCopy("ab", 2);
+    if (assigned.size() != 2 || assigned.segmentCount() != 1) {
+        std::cout << "BufferChain reuse after move went wrong\n";
+        ok = false;
+    }
+    return ok;
+}
+
+int main() {
+    bool ok = move_leaves_source_empty();
+    std::cout << (ok ? "buffer_chain_test passed" : "buffer_chain_test failed") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "ByteVector.h"
+#include "MemoryPool.h"
+
+// Moving contents that fit inline out of a pooled vector must hand its block back.
+// Leaking would leave every iteration's block in use; the pool's figures only lag by
+// what the thread's magazines hold, well under the total.
+bool move_into_inline_storage_releases_pool_block() {
+    const std::vector<std::uint8_t> source(5000, 0x5A);
+    constexpr std::size_t moves = 1024;
+    std::size_t in_use_before = FastVector::MemoryPool::getInstance().stats().bytes_in_use;
+    for (std::size_t i = 0; i < moves; ++i) {
+        FastVector::HeapByteVector pooled(source.begin(), source.end());
+        pooled.resize(10);
+        FastVector::TinyByteVector small(std::move(pooled));
+        if (small.size() != 10 || !std::all_of(small.begin(), small.end(), [](std::uint8_t b) { return b == 0x5A; })) {
+            std::cout << "ByteVector move into inline storage lost its contents\n";
+            return false;
+        }
+        if (!pooled.empty()) {
+            std::cout << "ByteVector move into inline storage left the source non-empty\n";
+            return false;
+        }
+    }
+    std::size_t in_use_after = FastVector::MemoryPool::getInstance().stats().bytes_in_use;
+    if (in_use_after > in_use_before + moves / 2 * source.size()) {
+        std::cout << "ByteVector move into inline storage leaked " << (in_use_after - in_use_before)
+                  << " bytes of pool blocks\n";
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = move_into_inline_storage_releases_pool_block();
+    std::cout << (ok ? "byte_vector_test passed" : "byte_vector_test failed") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "BinaryData.h"
+#include "ByteVector.h"
+#include "DynamicPayload.h"
+#include "chat_messages.h"  // Generated from chat_messages.json
+
+// The structs serverkit_codegen generates from a definitions file must be wire
+// compatible with the DynamicPayload messages loaded from the same file: each side
+// encodes the same bytes and decodes the other's.
+// Usage: generated_messages_test <path to chat_messages.json>
+
+// Encodes the message through DynamicPayload, filled in by fill, and compares the bytes
+template<typename Fill>
+bool encodes_like_dynamic(const std::string& name, const FastVector::ByteVector& generated, Fill fill) {
+    auto dynamic = JSONPayload::MessageFactory::createMessage(name);
+    fill(dynamic->getPayload());
+    FastVector::ByteVector bytes = dynamic->serialize();
+    if (!std::equal(generated.begin(), generated.end(), bytes.begin(), bytes.end())) {
+        std::cout << "Generated " << name << " does not match the DynamicPayload encoding\n";
+        return false;
+    }
+    return true;
+}
+
+// Decodes the generated bytes through the definitions table, as a receiver would
+JSONPayload::DynamicPayload decode_dynamic(const std::string& name, const FastVector::ByteVector& generated) {
+    return JSONPayload::MessageFactory::decode(JSONPayload::MessageFactory::typeOf(name),
+                                               FastVector::ByteSpan(generated.data() + sizeof(short), generated.size() - sizeof(short)));
+}
+
+bool chat_message_matches() {
+    ChatSchema::ChatMessage message{.message = "Grüße aus dem Chat", .username = "user_0042"};
+    FastVector::ByteVector serialized = NetworkMessages::serializeMessage(message);
+    bool ok = encodes_like_dynamic("ChatMessage", serialized, [&](JSONPayload::DynamicPayload& payload) {
+        payload.set("message", message.message);
+        payload.set("username", message.username);
+    });
+
+    JSONPayload::DynamicPayload decoded = decode_dynamic("ChatMessage", serialized);
+    if (decoded.get<std::string>("message") != message.message || decoded.get<std::string>("username") != message.username) {
+        std::cout << "DynamicPayload decoded a different ChatMessage\n";
+        ok = false;
+    }
+
+    auto dynamic = JSONPayload::createMessage("ChatMessage", message.message, message.username);
+    auto round_trip = NetworkMessages::deserializeMessage<ChatSchema::ChatMessage>(dynamic->serialize());
+    if (round_trip.message != message.message || round_trip.username != message.username) {
+        std::cout << "Generated ChatMessage decoded different fields\n";
+        ok = false;
+    }
+    return ok;
+}
+
+bool test_message_matches() {
+    ChatSchema::TestMessage message{.test_float = -1.75f, .test_int = -123456789, .test_string = "scalars"};
+    FastVector::ByteVector serialized = NetworkMessages::serializeMessage(message);
+    bool ok = encodes_like_dynamic("TestMessage", serialized, [&](JSONPayload::DynamicPayload& payload) {
+        payload.set("test_float", message.test_float);
+        payload.set("test_int", message.test_int);
+        payload.set("test_string", message.test_string);
+    });
+
+    JSONPayload::DynamicPayload decoded = decode_dynamic("TestMessage", serialized);
+    if (decoded.get<float>("test_float") != message.test_float || decoded.get<int>("test_int") != message.test_int ||
+        decoded.get<std::string>("test_string") != message.test_string) {
+        std::cout << "DynamicPayload decoded a different TestMessage\n";
+        ok = false;
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cout << "Usage: " << argv[0] << " <chat_messages.json>\n";
+        return 1;
+    }
+    try {
+        JSONPayload::MessageFactory::loadDefinitions(argv[1]);
+    } catch (const std::exception& e) {
+        std::cout << "Cannot load " << argv[1] << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    bool ok = true;
+    try {
+        ok = chat_message_matches() && ok;
+        ok = test_message_matches() && ok;
+    } catch (const std::exception& e) {
+        std::cout << "Unexpected exception: " << e.what() << "\n";
+        ok = false;
+    }
+    std::cout << (ok ? "generated_messages_test passed" : "generated_messages_test failed") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// Turns a DynamicPayload definitions file into a header of SERVERKIT_MESSAGE structs,
+// so a deployment with a fixed schema can encode and decode with the compile-time
+// MessageCodec instead of interpreting the definitions at runtime.
+//
+// Usage: serverkit_codegen <definitions.json> <output.h> [namespace]
+//
+// Fields are declared in DynamicPayload's wire order, which is the order nlohmann::json
+// iterates them in (sorted by name), and map to the C++ types MessageSchema encodes the
+// same way: "int" to int32_t, "bytes" to FastVector::ByteVector, "T[N]" to std::array
+// and "T[]" to std::vector. Messages come out after the ones they contain. Messages whose
+// fields are all non-bool numbers without padding between them are declared packed, so
+// they encode with one memcpy.
+
+using json = nlohmann::json;
+
+struct Scalar {
+    const char* cpp;
+    std::size_t size;
+};
+
+const std::map<std::string, Scalar>& scalars() {
+    static const std::map<std::string, Scalar> table = {
+            {"bool", {"bool", 1}}, {"int8", {"std::int8_t", 1}}, {"int16", {"std::int16_t", 2}},
+            {"int32", {"std::int32_t", 4}}, {"int", {"std::int32_t", 4}}, {"int64", {"std::int64_t", 8}},
+            {"uint8", {"std::uint8_t", 1}}, {"uint16", {"std::uint16_t", 2}}, {"uint32", {"std::uint32_t", 4}},
+            {"uint64", {"std::uint64_t", 8}}, {"float", {"float", 4}}, {"double", {"double", 8}}};
+    return table;
+}
+
+struct Field {
+    std::string name;
+    std::string base;      // Definition type without the array suffix
+    std::size_t count = 1;
+    bool repeated = false;
+};
+
+struct Message {
+    std::string name;
+    short type = 0;
+    std::vector<Field> fields;
+    bool packed = false;
+    std::size_t size = 0;       // sizeof the struct when packed
+    std::size_t alignment = 1;
+};
+
+bool is_identifier(const std::string& name) {
+    static const std::set<std::string> reserved = {
+            "alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char", "class",
+            "concept", "const", "constexpr", "continue", "default", "delete", "do", "double", "else", "enum",
+            "explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int",
+            "long", "mutable", "namespace", "new", "noexcept", "not", "nullptr", "operator", "or", "private",
+            "protected", "public", "register", "requires", "return", "short", "signed", "sizeof", "static",
+            "struct", "switch", "template", "this", "throw", "true", "try", "typedef", "typename", "union",
+            "unsigned", "using", "virtual", "void", "volatile", "while", "View", "MessageTypeId"};
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])) || reserved.count(name)) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    });
+}
+
+Field parse_field(const std::string& message, const std::string& name, const json& type) {
+    if (!is_identifier(name)) {
+        throw std::runtime_error(message + "." + name + " is not a valid C++ member name");
+    }
+    if (!type.is_string()) {
+        throw std::runtime_error("Unknown field type in message definition: " + type.dump());
+    }
+    Field field;
+    field.name = name;
+    field.base = type.get<std::string>();
+    std::size_t bracket = field.base.find('[');
+    if (bracket != std::string::npos) {
+        std::string length = field.base.substr(bracket + 1);
+        field.base.resize(bracket);
+        if (length.empty() || length.back() != ']') {
+            throw std::runtime_error("Invalid array type for field " + name + ": " + type.get<std::string>());
+        }
+        length.pop_back();
+        if (length.empty()) {
+            field.repeated = true;
+        } else {
+            if (length.size() > 5 || length.find_first_not_of("0123456789") != std::string::npos ||
+                std::stoul(length) == 0 || std::stoul(length) > 0xFFFF) {
+                throw std::runtime_error("Invalid array length for field " + name + ": " + type.get<std::string>());
+            }
+            field.count = std::stoul(length);
+        }
+    }
+    if (field.base == "bytes" && (field.repeated || field.count != 1)) {
+        throw std::runtime_error("Arrays of bytes are not supported, field " + name);
+    }
+    return field;
+}
+
+class Generator {
+public:
+    explicit Generator(const json& definitions) : definitions_(definitions) {
+        for (const auto& [name, definition] : definitions_.items()) {
+            emit(name);
+        }
+    }
+
+    std::string header(const std::string& source, const std::string& ns) const {
+        std::ostringstream out;
+        out << "// Generated by serverkit_codegen from " << source << "; do not edit.\n"
+            << "#pragma once\n\n"
+            << "#include <array>\n#include <cstdint>\n#include <string>\n#include <vector>\n\n"
+            << "#include \"BinaryData.h\"\n\n"
+            << "namespace " << ns << "\n{\n";
+        for (const auto& message : order_) {
+            out << "\n";
+            write_message(out, message);
+        }
+        out << "\n}\n";
+        return out.str();
+    }
+
+private:
+    // Adds name to the output after every message it contains
+    const Message& emit(const std::string& name) {
+        auto done = emitted_.find(name);
+        if (done != emitted_.end()) {
+            return order_[done->second];
+        }
+        if (!definitions_.contains(name)) {
+            throw std::runtime_error("Message definition not found: " + name);
+        }
+        if (std::find(compiling_.begin(), compiling_.end(), name) != compiling_.end()) {
+            throw std::runtime_error("Message definition contains itself: " + name);
+        }
+        if (!is_identifier(name)) {
+            throw std::runtime_error(name + " is not a valid C++ type name");
+        }
+        compiling_.push_back(name);
+
+        const json& definition = definitions_.at(name);
+        if (!definition.is_object() || !definition.contains("type") || !definition.contains("fields") ||
+            !definition.at("type").is_number_integer() || !definition.at("fields").is_object()) {
+            throw std::runtime_error("Message definition " + name +
+                                     " needs an integer \"type\" and a \"fields\" object");
+        }
+        Message message;
+        message.name = name;
+        message.type = definition.at("type").get<short>();
+        if (message.type < 0 || !types_.insert(message.type).second) {
+            throw std::runtime_error("Message type " + std::to_string(message.type) + " of " + name +
+                                     " is negative or already in use");
+        }
+
+        // Packed if every field is a fixed-width number placed without padding
+        message.packed = true;
+        for (const auto& [key, type] : definition.at("fields").items()) {
+            Field field = parse_field(name, key, type);
+            std::size_t size;
+            std::size_t alignment;
+            bool packable = !field.repeated && field.base != "bool";
+            auto scalar = scalars().find(field.base);
+            if (scalar != scalars().end()) {
+                size = alignment = scalar->second.size;
+            } else if (field.base == "string" || field.base == "bytes") {
+                size = alignment = 1;
+                packable = false;
+            } else {
+                const Message& nested = emit(field.base);
+                packable = packable && nested.packed;
+                size = nested.size;
+                alignment = nested.alignment;
+            }
+            if (packable && message.size % alignment == 0) {
+                message.size += size * field.count;
+                message.alignment = std::max(message.alignment, alignment);
+            } else {
+                message.packed = false;
+            }
+            message.fields.push_back(std::move(field));
+        }
+        message.packed = message.packed && !message.fields.empty() && message.size % message.alignment == 0;
+
+        compiling_.pop_back();
+        emitted_[name] = order_.size();
+        order_.push_back(std::move(message));
+        return order_.back();
+    }
+
+    static std::string cpp_type(const Field& field) {
+        std::string element;
+        auto scalar = scalars().find(field.base);
+        if (scalar != scalars().end()) {
+            element = scalar->second.cpp;
+        } else if (field.base == "string") {
+            element = "std::string";
+        } else if (field.base == "bytes") {
+            element = "FastVector::ByteVector";
+        } else {
+            element = field.base;
+        }
+        if (field.repeated) {
+            return "std::vector<" + element + ">";
+        }
+        if (field.count != 1) {
+            return "std::array<" + element + ", " + std::to_string(field.count) + ">";
+        }
+        return element;
+    }
+
+    static void write_message(std::ostringstream& out, const Message& message) {
+        out << "struct " << message.name << " {\n";
+        for (const auto& field : message.fields) {
+            out << "    " << cpp_type(field) << " " << field.name << "{};\n";
+        }
+
+        std::string names;
+        for (const auto& field : message.fields) {
+            names += ", " + field.name;
+        }
+        if (message.fields.empty()) {
+            // The macro needs at least one field
+            out << "    static constexpr short MessageTypeId = " << message.type << ";\n"
+                << "    friend constexpr auto serverkit_fields(const " << message.name << "*) { return std::tuple<>(); }\n";
+        } else if (message.fields.size() <= 16) {
+            out << "    " << (message.packed ? "SERVERKIT_PACKED_MESSAGE(" : "SERVERKIT_MESSAGE(")
+                << message.name << ", " << message.type << names << ")\n";
+        } else {
+            // Past the macro's field limit: the same declarations by hand, without View
+            out << "    static constexpr short MessageTypeId = " << message.type << ";\n"
+                << "    friend constexpr auto serverkit_fields(const " << message.name << "*) {\n"
+                << "        return std::make_tuple(";
+            for (std::size_t i = 0; i < message.fields.size(); ++i) {
+                out << (i ? ", " : "") << "&" << message.name << "::" << message.fields[i].name;
+            }
+            out << ");\n    }\n";
+            if (message.packed) {
+                out << "    static constexpr bool PackedLayout = true;\n";
+            }
+        }
+        out << "};\n";
+    }
+
+    const json& definitions_;
+    std::vector<Message> order_;
+    std::map<std::string, std::size_t> emitted_;
+    std::vector<std::string> compiling_;
+    std::set<short> types_;
+};
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 4) {
+        std::cerr << "Usage: serverkit_codegen <definitions.json> <output.h> [namespace]\n";
+        return 2;
+    }
+    std::string input = argv[1];
+    std::string output = argv[2];
+    std::string ns = argc == 4 ? argv[3] : "GeneratedMessages";
+
+    try {
+        if (!is_identifier(ns)) {
+            throw std::runtime_error(ns + " is not a valid namespace name");
+        }
+        std::ifstream file(input);
+        if (!file) {
+            throw std::runtime_error("Cannot open " + input);
+        }
+        json definitions;
+        file >> definitions;
+
+        std::string source = input.substr(input.find_last_of("/\\") + 1);
+        std::string header = Generator(definitions).header(source, ns);
+
+        // Leave an unchanged header alone so its dependents are not rebuilt
+        std::ifstream existing(output, std::ios::binary);
+        std::string current((std::istreambuf_iterator<char>(existing)), std::istreambuf_iterator<char>());
+        if (current != header) {
+            std::ofstream out(output, std::ios::binary | std::ios::trunc);
+            out << header;
+            if (!out) {
+                throw std::runtime_error("Cannot write " + output);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "serverkit_codegen: " << input << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}